@@ -224,6 +224,21 @@ function builtin_shared.cache_content_ids()
 	end
 end
 
+-- Cache content IDs as they are looked up, for environments where they
+-- can't change anymore. Unlike the above this doesn't need the node list.
+function builtin_shared.cache_content_ids_on_demand()
+	getmetatable(name2content).__index = function(self, name)
+		local id = old_get_content_id(name)
+		self[name] = id
+		return id
+	end
+	getmetatable(content2name).__index = function(self, id)
+		local name = old_get_name_from_content_id(id)
+		self[id] = name
+		return name
+	end
+end
+
 if core.set_read_node and core.set_push_node then
 	local function read_node(node)
 		return name2content[node.name], node.param1, node.param2
@@ -10,12 +10,13 @@ assert(loadfile(commonpath .. "item_s.lua"))(builtin_shared)
 dofile(gamepath .. "misc_s.lua")
 dofile(gamepath .. "features.lua")
 dofile(gamepath .. "voxelarea.lua")
+dofile(gamepath .. "transfer_s.lua")
 
 -- Now for our own stuff
 assert(loadfile(commonpath .. "register.lua"))(builtin_shared)
 assert(loadfile(epath .. "register.lua"))(builtin_shared)
 dofile(epath .. "env.lua")
 
-builtin_shared.cache_content_ids()
+builtin_shared.cache_content_ids_on_demand()
 
 core.log("info", "Initialized emerge Lua environment")
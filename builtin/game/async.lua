@@ -8,15 +8,46 @@ function core.async_event_handler(jobid, retval)
 	core.async_jobs[jobid] = nil
 end
 
-function core.handle_async(func, callback, ...)
-	assert(type(func) == "function" and type(callback) == "function",
-		"Invalid core.handle_async invocation")
+local function handle_async(func, callback, priority, ...)
 	local args = {n = select("#", ...), ...}
 	local mod_origin = core.get_last_run_mod()
 
-	local jobid = core.do_async_callback(func, args, mod_origin)
+	local jobid = core.do_async_callback(func, args, mod_origin, priority)
 	core.async_jobs[jobid] = callback
 
 	return true
 end
 
+function core.handle_async(func, callback, ...)
+	assert(type(func) == "function" and type(callback) == "function",
+		"Invalid core.handle_async invocation")
+	return handle_async(func, callback, nil, ...)
+end
+
+function core.handle_async_with_priority(func, callback, priority, ...)
+	assert(type(func) == "function" and type(callback) == "function" and
+		type(priority) == "number",
+		"Invalid core.handle_async_with_priority invocation")
+	return handle_async(func, callback, priority, ...)
+end
+
+
+function core.handle_async_batch(func, callback, args_list, priority)
+	assert(type(func) == "function" and type(callback) == "function" and
+		type(args_list) == "table", "Invalid core.handle_async_batch invocation")
+	assert(priority == nil or type(priority) == "number",
+		"Invalid core.handle_async_batch invocation")
+	if #args_list == 0 then
+		return true
+	end
+	local mod_origin = core.get_last_run_mod()
+
+	local first_jobid = core.do_async_batch(func, args_list, mod_origin, priority)
+	for i = 1, #args_list do
+		core.async_jobs[first_jobid + i - 1] = function(...)
+			return callback(i, ...)
+		end
+	end
+
+	return true
+end
@@ -255,18 +255,21 @@ local function copy_filtering(t, seen)
 	return n
 end
 
+-- Every field is transferred on its own and only unpacked by the other
+-- environments once it is used, see transfer_s.lua
 function core.get_globals_to_transfer()
 	local all = {
-		registered_items = copy_filtering(core.registered_items),
+		items = {
+			registered_items = copy_filtering(core.registered_items),
+			nodedef_default = copy_filtering(core.nodedef_default),
+			craftitemdef_default = copy_filtering(core.craftitemdef_default),
+			tooldef_default = copy_filtering(core.tooldef_default),
+			noneitemdef_default = copy_filtering(core.noneitemdef_default),
+		},
 		registered_aliases = core.registered_aliases,
 		registered_biomes = core.registered_biomes,
 		registered_ores = core.registered_ores,
 		registered_decorations = core.registered_decorations,
-
-		nodedef_default = copy_filtering(core.nodedef_default),
-		craftitemdef_default = copy_filtering(core.craftitemdef_default),
-		tooldef_default = copy_filtering(core.tooldef_default),
-		noneitemdef_default = copy_filtering(core.noneitemdef_default),
 	}
 	return all
 end
@@ -0,0 +1,75 @@
+-- Registration data of the server environment (see core.get_globals_to_transfer)
+-- is only unpacked once it is first used, so that environments don't pay for
+-- data they never look at.
+
+local get_transferred_global = core.get_transferred_global
+core.get_transferred_global = nil
+
+-- For tables that are indexed by item name:
+-- If table[X] does not exist, default to table[core.registered_aliases[X]]
+local alias_metatable = {
+	__index = function(t, name)
+		return rawget(t, core.registered_aliases[name])
+	end,
+	__newindex = function()
+		error("table is read-only")
+	end
+}
+
+local function load_items()
+	local all = assert(get_transferred_global("items"))
+
+	all.registered_nodes = {}
+	all.registered_craftitems = {}
+	all.registered_tools = {}
+	for k, v in pairs(all.registered_items) do
+		-- Ignore new keys
+		setmetatable(v, {__newindex = function() end})
+		-- Reassemble the other tables
+		if v.type == "node" then
+			getmetatable(v).__index = all.nodedef_default
+			all.registered_nodes[k] = v
+		elseif v.type == "craft" then
+			getmetatable(v).__index = all.craftitemdef_default
+			all.registered_craftitems[k] = v
+		elseif v.type == "tool" then
+			getmetatable(v).__index = all.tooldef_default
+			all.registered_tools[k] = v
+		else
+			getmetatable(v).__index = all.noneitemdef_default
+		end
+	end
+
+	setmetatable(all.registered_items, alias_metatable)
+	setmetatable(all.registered_nodes, alias_metatable)
+	setmetatable(all.registered_craftitems, alias_metatable)
+	setmetatable(all.registered_tools, alias_metatable)
+
+	for k, v in pairs(all) do
+		rawset(core, k, v)
+	end
+end
+
+local loaders = {}
+for _, name in ipairs({"registered_items", "registered_nodes",
+		"registered_craftitems", "registered_tools", "nodedef_default",
+		"craftitemdef_default", "tooldef_default", "noneitemdef_default"}) do
+	loaders[name] = load_items
+end
+for _, name in ipairs({"registered_aliases", "registered_biomes",
+		"registered_ores", "registered_decorations"}) do
+	loaders[name] = function()
+		rawset(core, name, get_transferred_global(name))
+	end
+end
+
+setmetatable(core, {
+	__index = function(t, key)
+		local loader = loaders[key]
+		if loader then
+			loaders[key] = nil
+			loader()
+			return rawget(t, key)
+		end
+	end,
+})
@@ -108,6 +108,12 @@ local function test_userdata_passing(_, pos)
 	local expect = vm:get_node_at(pos)
 	local vm2 = core.serialize_roundtrip(vm)
 	assert(deepequal(vm2:get_node_at(pos), expect))
+
+	-- VManip: moved instead of copied
+	vm:set_move_on_transfer(true)
+	local vm3 = core.serialize_roundtrip(vm)
+	assert(deepequal(vm3:get_node_at(pos), expect))
+	assert(#vm:get_data() == 0)
 end
 unittests.register("test_userdata_passing", test_userdata_passing, {map=true})
 
@@ -142,6 +148,73 @@ local function test_handle_async(cb)
 end
 unittests.register("test_handle_async", test_handle_async, {async=true})
 
+local function test_handle_async_batch(cb)
+	-- Invalid batches fail as a whole, before any job is queued
+	local big = string.rep("x", 65536)
+	local function fail()
+		cb("Job of an invalid batch ran")
+	end
+	if pcall(core.handle_async_batch, fail, fail, {{big}, "invalid"}) then
+		return cb("Batch with a non-table entry was accepted")
+	end
+	if pcall(core.handle_async_batch, fail, fail, {{big}, {coroutine.create(fail)}}) then
+		return cb("Batch with a coroutine argument was accepted")
+	end
+
+	local args_list = {}
+	for i = 1, 20 do
+		args_list[i] = {i, i % 3 == 0 and "x" or nil}
+	end
+
+	local results = {}
+	local remaining = #args_list
+	core.handle_async_batch(function(n, s)
+		return n * 2, s
+	end, function(i, n2, s)
+		if n2 ~= i * 2 or s ~= args_list[i][2] then
+			return cb("Wrong result for job " .. i)
+		end
+		if results[i] then
+			return cb("Callback ran twice for job " .. i)
+		end
+		results[i] = true
+		remaining = remaining - 1
+		if remaining == 0 then
+			cb()
+		end
+	end, args_list, 5)
+end
+unittests.register("test_handle_async_batch", test_handle_async_batch, {async=true})
+
+local function test_handle_async_with_priority(cb)
+	core.handle_async_with_priority(function(a, b)
+		return a + b
+	end, function(sum)
+		if sum ~= 3 then
+			return cb("Wrong result")
+		end
+		cb()
+	end, 10, 1, 2)
+end
+unittests.register("test_handle_async_with_priority", test_handle_async_with_priority, {async=true})
+
+local function test_handle_async_large_string(cb)
+	-- Large strings are read from this environment instead of being copied
+	local big = string.rep("luanti", 20000)
+	core.handle_async(function(a, b, t)
+		return a, a == b and t[1] == a and t[a] == true
+	end, function(ret, same)
+		if ret ~= big then
+			return cb("String did not survive the roundtrip")
+		end
+		if not same then
+			return cb("Repeated string did not arrive intact")
+		end
+		cb()
+	end, big, big, {big, [big] = true})
+end
+unittests.register("test_handle_async_large_string", test_handle_async_large_string, {async=true})
+
 local function test_userdata_passing2(cb, _, pos)
 	-- VManip: check transfer into other env
 	local vm = core.get_voxel_manip(pos, pos)
@@ -186,6 +186,24 @@ local function test_entity_raycast(_, pos)
 end
 unittests.register("test_entity_raycast", test_entity_raycast, {map=true})
 
+local function test_entity_movement(_, pos)
+	local obj = core.add_entity(pos, "unittests:dummy")
+	assert(obj:get_movement() == nil)
+
+	obj:set_movement({target = pos:offset(5, 0, 0), speed = 2, gravity = 9.81})
+	local movement = obj:get_movement()
+	assert(movement.target:equals(pos:offset(5, 0, 0)))
+	assert(movement.speed == 2)
+	assert(math.abs(movement.gravity - 9.81) < 0.001)
+	assert(movement.jump == 0)
+	assert(movement.on_step_interval == 0)
+
+	obj:set_movement(nil)
+	assert(obj:get_movement() == nil)
+	obj:remove()
+end
+unittests.register("test_entity_movement", test_entity_movement, {map=true})
+
 local function test_object_iterator(pos, make_iterator)
 	local obj1 = core.add_entity(pos, "unittests:dummy")
 	local obj2 = core.add_entity(pos, "unittests:dummy")
@@ -215,6 +233,38 @@ unittests.register("test_objects_in_area", function(_, pos)
 	end)
 end, {map=true})
 
+local function test_query_objects(_, pos)
+	local obj = core.add_entity(pos, "unittests:dummy")
+	obj:set_velocity(vector.new(0, 0, 1))
+	obj:set_armor_groups({test = 50})
+	local fields = {"id", "object", "pos", "velocity", "name", "is_player",
+		"hp", "armor_groups"}
+
+	local function check(result)
+		local i = table.indexof(result.object, obj)
+		assert(i > 0)
+		assert(core.object_refs[result.id[i]] == obj)
+		assert(result.pos[i]:equals(obj:get_pos()))
+		assert(result.velocity[i]:equals(obj:get_velocity()))
+		assert(result.name[i] == "unittests:dummy")
+		assert(result.is_player[i] == false)
+		assert(result.hp[i] == obj:get_hp())
+		assert(result.armor_groups[i].test == 50)
+		for _, field in ipairs(fields) do
+			assert(#result[field] == #result.id)
+		end
+	end
+	check(core.query_objects_inside_radius(pos, 1, fields))
+	check(core.query_objects_in_area(pos:offset(-1, -1, -1), pos:offset(1, 1, 1), fields))
+
+	-- Only the requested fields are returned
+	local result = core.query_objects_inside_radius(pos, 1, {"pos"})
+	assert(result.pos and not result.object)
+	assert(not pcall(core.query_objects_inside_radius, pos, 1, {"nope"}))
+	obj:remove()
+end
+unittests.register("test_query_objects", test_query_objects, {map=true})
+
 -- Tests that bone rotation euler angles are preserved (see #14992)
 local function test_get_bone_rot(_, pos)
 	local obj = core.add_entity(pos, "unittests:dummy")
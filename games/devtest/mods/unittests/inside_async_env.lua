@@ -11,6 +11,7 @@ local function do_tests()
 	assert(not core.get_player_by_name)
 	assert(not core.set_node)
 	assert(not core.object_refs)
+	assert(not core.get_transferred_global)
 	-- stuff that should be here
 	assert(ItemStack)
 	local meta = ItemStack():get_meta()
@@ -19,6 +20,7 @@ local function do_tests()
 	assert(core.registered_items[""])
 	assert(next(core.registered_nodes) ~= nil)
 	assert(core.registered_craftitems["unittests:stick"])
+	assert(type(core.registered_biomes) == "table")
 	-- alias handling
 	assert(core.registered_items["unittests:steel_ingot_alias"].name ==
 		"unittests:steel_ingot")
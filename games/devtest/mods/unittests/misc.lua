@@ -106,6 +106,79 @@ local function test_node_callbacks(_, pos)
 end
 unittests.register("test_node_callbacks", test_node_callbacks, {map=true})
 
+local function test_bulk_set_node_light(_, pos)
+	local layer, sources = {}, {}
+	for x = 0, 4 do
+	for z = 0, 4 do
+		local p = pos:offset(x, 0, z)
+		table.insert(layer, p)
+		if x % 2 == 0 and z % 2 == 0 then
+			table.insert(sources, p)
+		end
+	end
+	end
+	core.bulk_set_node(layer, {name="air"})
+
+	-- Lighting is updated once for all nodes, check the result with night light
+	core.bulk_set_node(sources, {name="basenodes:lava_source"})
+	assert(core.get_node_light(pos, 0) == core.LIGHT_MAX)
+	assert(core.get_node_light(pos:offset(1, 0, 0), 0) == core.LIGHT_MAX - 1)
+	assert(core.get_node_light(pos:offset(3, 0, 4), 0) == core.LIGHT_MAX - 1)
+
+	core.bulk_set_node(sources, {name="air"})
+	assert(core.get_node_light(pos:offset(1, 0, 0), 0) < core.LIGHT_MAX - 1)
+	assert(core.get_node_light(pos:offset(3, 0, 4), 0) < core.LIGHT_MAX - 1)
+end
+unittests.register("test_bulk_set_node_light", test_bulk_set_node_light, {map=true})
+
+local function test_bulk_get_node(_, pos)
+	local positions = {}
+	for x = 0, 2 do
+	for y = 0, 1 do
+		table.insert(positions, pos:offset(x, y, 0))
+	end
+	end
+	core.bulk_set_node(positions, {name="air"})
+	core.set_node(pos, {name="basenodes:stone"})
+	core.set_node(pos:offset(1, 0, 0), {name="basenodes:lava_source"})
+	core.swap_node(pos:offset(2, 1, 0), {name="air", param2=7})
+
+	local ids, param1s, param2s = core.bulk_get_node_data(positions)
+	assert(#ids == #positions and #param1s == #positions and #param2s == #positions)
+	for i, p in ipairs(positions) do
+		local node = core.get_node(p)
+		assert(core.get_name_from_content_id(ids[i]) == node.name)
+		assert(param1s[i] == node.param1)
+		assert(param2s[i] == node.param2)
+	end
+
+	-- Areas are returned in the order of VoxelArea:index()
+	local minp, maxp = pos, pos:offset(2, 1, 0)
+	local va = VoxelArea(minp, maxp)
+	local area_ids, _, area_param2s = core.bulk_get_node_data(maxp, minp)
+	assert(#area_ids == va:getVolume())
+	for i, p in ipairs(positions) do
+		assert(area_ids[va:indexp(p)] == ids[i])
+		assert(area_param2s[va:indexp(p)] == param2s[i])
+	end
+
+	local lights = core.bulk_get_node_light(positions, 0)
+	for i, p in ipairs(positions) do
+		assert(lights[i] == core.get_node_light(p, 0))
+	end
+	local area_lights = core.bulk_get_node_light(minp, maxp, 0.5)
+	for _, p in ipairs(positions) do
+		assert(area_lights[va:indexp(p)] == core.get_node_light(p, 0.5))
+	end
+
+	-- Unloaded positions
+	local far = vector.new(0, -30000, 0)
+	ids = core.bulk_get_node_data({far})
+	assert(ids[1] == core.CONTENT_IGNORE)
+	assert(core.bulk_get_node_light({far})[1] == false)
+end
+unittests.register("test_bulk_get_node", test_bulk_get_node, {map=true})
+
 local function test_hashing()
 	local input = "hello\000world"
 	assert(core.sha1(input) == "f85b420f1e43ebf88649dfcab302b898d889606c")
@@ -245,6 +318,86 @@ local function test_mapgen_edges(cb)
 end
 unittests.register("test_mapgen_edges", test_mapgen_edges, {map=true, async=true})
 
+local server_step = 0
+core.register_globalstep(function()
+	server_step = server_step + 1
+end)
+local function test_emerge_area_batched(cb, player, pos)
+	-- Emerge the same area twice, batched and per block. The batched request
+	-- was made first, so it must see every block no later than the other one.
+	local bp1 = (pos / core.MAP_BLOCKSIZE):floor():add(2)
+	local bp2 = bp1:add(2)
+	local total = 27
+	local failed = false
+	local function fail(msg)
+		if not failed then
+			failed = true
+			cb(msg)
+		end
+	end
+	local batched_step, single_step = {}, {}
+	local batched_count, single_count = 0, 0
+	local function finish()
+		if batched_count < total or single_count < total then
+			return
+		end
+		for h, step in pairs(single_step) do
+			if not batched_step[h] then
+				return fail("Blocks of the requests differ")
+			elseif batched_step[h] > step then
+				return fail("Batched block delivered late")
+			end
+		end
+		-- Give stray callbacks a chance to turn up
+		core.after(0.2, function()
+			if not failed then
+				cb()
+			end
+		end)
+	end
+	local function deliver(steps, blockpos, action)
+		local h = core.hash_node_position(blockpos)
+		if steps[h] then
+			return false, "Block delivered twice"
+		elseif action == core.EMERGE_CANCELLED or action == core.EMERGE_ERRORED then
+			return false, "Block failed to emerge"
+		end
+		steps[h] = server_step
+		return true
+	end
+
+	local minp = bp1 * core.MAP_BLOCKSIZE
+	local maxp = (bp2 * core.MAP_BLOCKSIZE):add(core.MAP_BLOCKSIZE - 1)
+	core.emerge_area(minp, maxp, function(blockposes, actions, remaining)
+		if #blockposes == 0 or #blockposes ~= #actions then
+			return fail("Unexpected batch")
+		end
+		for i, blockpos in ipairs(blockposes) do
+			local ok, err = deliver(batched_step, blockpos, actions[i])
+			if not ok then
+				return fail(err)
+			end
+		end
+		batched_count = batched_count + #blockposes
+		if remaining ~= total - batched_count then
+			return fail("Wrong number of remaining blocks in batch")
+		end
+		finish()
+	end, nil, true)
+	core.emerge_area(minp, maxp, function(blockpos, action, remaining)
+		local ok, err = deliver(single_step, blockpos, action)
+		if not ok then
+			return fail(err)
+		end
+		single_count = single_count + 1
+		if remaining ~= total - single_count then
+			return fail("Wrong number of remaining blocks")
+		end
+		finish()
+	end)
+end
+unittests.register("test_emerge_area_batched", test_emerge_area_batched, {map=true, async=true})
+
 local finish_test_on_mapblocks_changed
 core.register_on_mapblocks_changed(function(modified_blocks, modified_block_count)
 	if finish_test_on_mapblocks_changed then
@@ -341,3 +494,33 @@ local function test_ipc_poll(cb)
 	print("delta: " .. (core.get_us_time() - t0) .. "us")
 end
 unittests.register("test_ipc_poll", test_ipc_poll)
+
+local function test_voxelmanip_view()
+	local vm = core.get_voxel_manip()
+	local pmin, pmax = vm:initialize(vector.new(0, 0, 0), vector.new(15, 15, 15),
+		{name="air", param2=3})
+	local volume = VoxelArea(pmin, pmax):getVolume()
+
+	local content = vm:get_view()
+	local param2 = vm:get_view("param2")
+	assert(content:get_field() == "content")
+	assert(#content == volume)
+	assert(content[1] == core.CONTENT_AIR)
+	assert(content[volume + 1] == nil)
+	assert(content[0 / 0] == nil and content[math.huge] == nil)
+	assert(content[-2^40] == nil and content[1.5] == nil)
+	assert(param2[volume] == 3)
+
+	local c_stone = core.get_content_id("basenodes:stone")
+	content[2] = c_stone
+	param2[2] = 7
+	local data = vm:get_data()
+	assert(data[1] == core.CONTENT_AIR and data[2] == c_stone)
+	assert(vm:get_param2_data()[2] == 7)
+
+	-- Views follow the data of the VoxelManip
+	vm:close()
+	assert(#content == 0)
+	assert(not pcall(function() content[1] = c_stone end))
+end
+unittests.register("test_voxelmanip_view", test_voxelmanip_view)
@@ -6,33 +6,96 @@
 #include "voxelalgorithms.h"
 #include "dummygamedef.h"
 #include "dummymap.h"
+#include "mapgen/mapgen.h"
+#include "noise.h"
 
-TEST_CASE("benchmark_lighting")
-{
-	DummyGameDef gamedef;
-	NodeDefManager *ndef = gamedef.getWritableNodeDefManager();
+namespace {
 
-	v3s16 pmin(-16, -16, -16);
-	v3s16 pmax(15, 15, 15);
-	v3s16 bpmin = getNodeBlockPos(pmin), bpmax = getNodeBlockPos(pmax);
-	DummyMap map(&gamedef, bpmin, bpmax);
+struct LightingScenario {
+	const char *name;
+	// Fraction of nodes that block light
+	float occlusion;
+	// Fraction of nodes that are light sources
+	float density;
+};
 
-	content_t content_wall;
+const LightingScenario scenarios[] = {
+	{"open, few lights", 0.0f, 0.0005f},
+	{"open, many lights", 0.0f, 0.02f},
+	{"cave, few lights", 0.4f, 0.0005f},
+	{"cave, many lights", 0.4f, 0.02f},
+};
+
+struct LightingContent {
+	content_t wall;
+	content_t light;
+};
+
+LightingContent register_content(NodeDefManager *ndef)
+{
+	LightingContent c;
 	{
 		ContentFeatures f;
 		f.name = "stone";
-		content_wall = ndef->set(f.name, f);
+		c.wall = ndef->set(f.name, f);
 	}
-
-	content_t content_light;
 	{
 		ContentFeatures f;
 		f.name = "light";
 		f.param_type = CPT_LIGHT;
 		f.light_propagates = true;
 		f.light_source = 14;
-		content_light = ndef->set(f.name, f);
+		c.light = ndef->set(f.name, f);
+	}
+	return c;
+}
+
+// Fills the VoxelManip with a random (but reproducible) mix of air, walls
+// and light sources
+void fill_scenario(MMVManip &vm, const LightingContent &c,
+	const LightingScenario &s)
+{
+	PcgRandom pr(42);
+	const s32 occlusion = s.occlusion * 10000;
+	const s32 density = s.density * 10000;
+	s32 volume = vm.m_area.getVolume();
+	for (s32 i = 0; i < volume; i++) {
+		s32 r = pr.range(0, 9999);
+		if (r < density)
+			vm.m_data[i] = MapNode(c.light);
+		else if (r < density + occlusion)
+			vm.m_data[i] = MapNode(c.wall);
+		else
+			vm.m_data[i] = MapNode(CONTENT_AIR);
 	}
+}
+
+// Fills the blocks of the map with the scenario and lights them
+void setup_map(DummyMap &map, v3s16 bpmin, v3s16 bpmax,
+	const LightingContent &c, const LightingScenario &s)
+{
+	std::map<v3s16, MapBlock*> modified_blocks;
+	MMVManip vm(&map);
+	vm.initialEmerge(bpmin, bpmax, false);
+	fill_scenario(vm, c, s);
+	voxalgo::blit_back_with_light(&map, &vm, &modified_blocks);
+}
+
+}
+
+TEST_CASE("benchmark_lighting")
+{
+	DummyGameDef gamedef;
+	NodeDefManager *ndef = gamedef.getWritableNodeDefManager();
+
+	v3s16 pmin(-16, -16, -16);
+	v3s16 pmax(15, 15, 15);
+	v3s16 bpmin = getNodeBlockPos(pmin), bpmax = getNodeBlockPos(pmax);
+	DummyMap map(&gamedef, bpmin, bpmax);
+
+	LightingContent c = register_content(ndef);
+	content_t content_wall = c.wall;
+	content_t content_light = c.light;
 
 	// Make a platform with a light below it.
 	{
@@ -69,3 +132,102 @@ TEST_CASE("benchmark_lighting")
 		});
 	};
 }
+
+TEST_CASE("benchmark_lighting_mapgen")
+{
+	DummyGameDef gamedef;
+	NodeDefManager *ndef = gamedef.getWritableNodeDefManager();
+	LightingContent c = register_content(ndef);
+
+	// A mapchunk of the default size (5 blocks) plus the shell of blocks
+	// around it, like the VoxelManip of a mapgen
+	const v3s16 node_min(0, 0, 0);
+	const v3s16 node_max = node_min + v3s16(5 * MAP_BLOCKSIZE - 1);
+	const v3s16 full_node_min = node_min - MAP_BLOCKSIZE;
+	const v3s16 full_node_max = node_max + MAP_BLOCKSIZE;
+	DummyMap map(&gamedef, v3s16(0, 0, 0), v3s16(-1, -1, -1));
+	MMVManip vm(&map);
+	vm.addArea(VoxelArea(full_node_min, full_node_max));
+
+	Mapgen mg;
+	mg.vm = &vm;
+	mg.ndef = ndef;
+	mg.water_level = -MAX_MAP_GENERATION_LIMIT;
+
+	for (const auto &s : scenarios) {
+		fill_scenario(vm, c, s);
+		// Nothing generated above the chunk yet, so sunlight comes in
+		for (s16 z = full_node_min.Z; z <= full_node_max.Z; z++)
+		for (s16 y = node_max.Y + 2; y <= full_node_max.Y; y++)
+		for (s16 x = full_node_min.X; x <= full_node_max.X; x++)
+			vm.m_data[vm.m_area.index(x, y, z)] = MapNode(CONTENT_IGNORE);
+
+		BENCHMARK_ADVANCED(std::string("Mapgen::calcLighting, ") + s.name)(Catch::Benchmark::Chronometer meter) {
+			meter.measure([&] {
+				// Includes resetting the light, which mapgens do as well
+				mg.setLighting(0, full_node_min, full_node_max);
+				mg.calcLighting(node_min - v3s16(0, 1, 0), node_max + v3s16(0, 1, 0),
+					full_node_min, full_node_max);
+			});
+		};
+	}
+}
+
+TEST_CASE("benchmark_lighting_update")
+{
+	DummyGameDef gamedef;
+	NodeDefManager *ndef = gamedef.getWritableNodeDefManager();
+	LightingContent c = register_content(ndef);
+
+	const v3s16 bpmin(-1, -1, -1), bpmax(1, 1, 1);
+	const v3s16 center(MAP_BLOCKSIZE / 2);
+
+	// Random positions in the central block for bulk edits
+	std::vector<v3s16> positions;
+	{
+		PcgRandom pr(7);
+		for (int i = 0; i < 64; i++) {
+			positions.emplace_back(pr.range(0, MAP_BLOCKSIZE - 1),
+				pr.range(0, MAP_BLOCKSIZE - 1), pr.range(0, MAP_BLOCKSIZE - 1));
+		}
+	}
+
+	for (const auto &s : scenarios) {
+		DummyMap map(&gamedef, bpmin, bpmax);
+		setup_map(map, bpmin, bpmax, c, s);
+		MapBlock *block = map.getBlockNoCreateNoEx(v3s16(0, 0, 0));
+		REQUIRE(block);
+
+		BENCHMARK_ADVANCED(std::string("voxalgo::update_lighting_nodes, 1 node, ") + s.name)(Catch::Benchmark::Chronometer meter) {
+			std::map<v3s16, MapBlock*> modified_blocks;
+			meter.measure([&] {
+				map.addNodeAndUpdate(center, MapNode(c.light), modified_blocks);
+				map.removeNodeAndUpdate(center, modified_blocks);
+			});
+		};
+
+		BENCHMARK_ADVANCED(std::string("voxalgo::update_lighting_nodes, 64 nodes, ") + s.name)(Catch::Benchmark::Chronometer meter) {
+			std::map<v3s16, MapBlock*> modified_blocks;
+			meter.measure([&] {
+				map.addNodesAndUpdate(positions, MapNode(c.light), modified_blocks);
+				map.addNodesAndUpdate(positions, MapNode(CONTENT_AIR), modified_blocks);
+			});
+		};
+
+		BENCHMARK_ADVANCED(std::string("voxalgo::repair_block_light, ") + s.name)(Catch::Benchmark::Chronometer meter) {
+			std::map<v3s16, MapBlock*> modified_blocks;
+			meter.measure([&] {
+				voxalgo::repair_block_light(&map, block, &modified_blocks);
+			});
+		};
+
+		BENCHMARK_ADVANCED(std::string("voxalgo::update_block_border_lighting, ") + s.name)(Catch::Benchmark::Chronometer meter) {
+			std::map<v3s16, MapBlock*> modified_blocks;
+			meter.measure([&] {
+				// As if the block was just loaded
+				block->setLightingComplete(0);
+				voxalgo::update_block_border_lighting(&map, block, modified_blocks);
+			});
+		};
+	}
+}
@@ -4,6 +4,9 @@
 
 #include "catch.h"
 #include "mapblock.h"
+#include "mapblockindex.h"
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
 typedef std::vector<MapBlock*> MBContainer;
@@ -170,3 +173,63 @@ TEST_CASE("benchmark_mapblock") {
 	BENCH1(2200)
 	BENCH1(7500) // <- default client_mapblock_limit
 }
+
+// A cube of blocks around the origin, like the loaded area around a player
+static std::vector<v3s16> blockCube(s16 radius)
+{
+	std::vector<v3s16> ret;
+	for (s16 z = -radius; z < radius; z++)
+	for (s16 y = -radius; y < radius; y++)
+	for (s16 x = -radius; x < radius; x++)
+		ret.emplace_back(x, y, z);
+	return ret;
+}
+
+// The sector/block layout that Map used before MapBlockIndex
+typedef std::unordered_map<s16, std::unique_ptr<MapBlock>> BlockColumn;
+typedef std::unordered_map<v2s16, BlockColumn> SectorMap;
+
+static MapBlock *getSectorBlock(const SectorMap &sectors, v3s16 p)
+{
+	auto it = sectors.find(v2s16(p.X, p.Z));
+	if (it == sectors.end())
+		return nullptr;
+	auto it2 = it->second.find(p.Y);
+	return it2 == it->second.end() ? nullptr : it2->second.get();
+}
+
+#define BENCH_LOOKUP(_radius) \
+	BENCHMARK_ADVANCED("lookup_sectors_" #_radius)(Catch::Benchmark::Chronometer meter) { \
+		SectorMap sectors; \
+		const auto positions = blockCube(_radius); \
+		for (v3s16 p : positions) \
+			sectors[v2s16(p.X, p.Z)][p.Y] = std::make_unique<MapBlock>(p, nullptr); \
+		meter.measure([&] { \
+			u32 found = 0; \
+			/* also look outside of the cube, where blocks are missing */ \
+			for (v3s16 p : positions) \
+				found += !!getSectorBlock(sectors, p * 2); \
+			return found; \
+		}); \
+	}; \
+	BENCHMARK_ADVANCED("lookup_index_" #_radius)(Catch::Benchmark::Chronometer meter) { \
+		MBContainer vec; \
+		MapBlockIndex index; \
+		const auto positions = blockCube(_radius); \
+		for (v3s16 p : positions) { \
+			vec.push_back(new MapBlock(p, nullptr)); \
+			index.set(p, vec.back()); \
+		} \
+		meter.measure([&] { \
+			u32 found = 0; \
+			for (v3s16 p : positions) \
+				found += !!index.get(p * 2); \
+			return found; \
+		}); \
+		freeAll(vec); \
+	};
+
+TEST_CASE("benchmark_mapblock_lookup") {
+	BENCH_LOOKUP(4)
+	BENCH_LOOKUP(10)
+}
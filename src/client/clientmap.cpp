@@ -1576,7 +1576,8 @@ void ClientMap::updateDrawListShadow(v3f shadow_light_pos, v3f shadow_light_dir,
 	g_profiler->avg("SHADOW MapBlocks loaded [#]", blocks_loaded);
 }
 
-void ClientMap::reportMetrics(u64 save_time_us, u32 saved_blocks, u32 all_blocks)
+void ClientMap::reportMetrics(u64 save_time_us, u32 saved_blocks, u32 all_blocks,
+	u32 compressed_blocks)
 {
 	g_profiler->avg("CM::reportMetrics loaded blocks [#]", all_blocks);
 }
@@ -120,7 +120,8 @@ class ClientMap : public Map, public scene::ISceneNode
 	// use drop() instead
 	virtual ~ClientMap();
 
-	void reportMetrics(u64 save_time_us, u32 saved_blocks, u32 all_blocks) override;
+	void reportMetrics(u64 save_time_us, u32 saved_blocks, u32 all_blocks,
+		u32 compressed_blocks) override;
 private:
 	bool isMeshOccluded(MapBlock *mesh_block, u16 mesh_size, v3s16 cam_pos_nodes);
 
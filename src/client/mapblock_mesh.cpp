@@ -60,6 +60,11 @@ void MeshMakeData::fillBlockData(const v3s16 &bp, MapNode *data)
 	m_vmanip.copyFrom(data, data_area, v3s16(0,0,0), blockpos_nodes, data_size);
 }
 
+void MeshMakeData::fillBlockData(MapBlock *block)
+{
+	block->copyTo(m_vmanip);
+}
+
 void MeshMakeData::fillSingleNode(MapNode data, MapNode padding)
 {
 	m_blockpos = {0, 0, 0};
@@ -61,6 +61,7 @@ struct MeshMakeData
 	*/
 	void fillBlockDataBegin(const v3s16 &blockpos);
 	void fillBlockData(const v3s16 &bp, MapNode *data);
+	void fillBlockData(MapBlock *block);
 
 	/*
 		Prepare block data for rendering a single node located at (0,0,0).
@@ -463,6 +463,7 @@ void set_default_settings()
 
     settings->setDefault("chat_message_format", "<@name> @message");
     settings->setDefault("profiler_print_interval", "0");
+    settings->setDefault("profiler.callback_metrics", "true");
     settings->setDefault("active_object_send_range_blocks", "8");
     settings->setDefault("active_block_range", "4");
     //settings->setDefault("max_simultaneous_block_sends_per_client", "1");
@@ -477,6 +478,7 @@ void set_default_settings()
     settings->setDefault("time_speed", "72");
     settings->setDefault("world_start_time", "6125");
     settings->setDefault("server_unload_unused_data_timeout", "29");
+    settings->setDefault("server_compress_unused_data_timeout", "10");
     settings->setDefault("max_objects_per_block", "256");
     settings->setDefault("server_map_save_interval", "5.3");
     settings->setDefault("chat_message_max_size", "500");
@@ -491,6 +493,8 @@ void set_default_settings()
     settings->setDefault("abm_interval", "1.0");
     settings->setDefault("abm_time_budget", "0.2");
     settings->setDefault("nodetimer_interval", "0.2");
+    settings->setDefault("async_result_time_budget", "50.0");
+    settings->setDefault("lua_gc_step_budget", "1.0");
     settings->setDefault("ignore_world_load_errors", "false");
     settings->setDefault("remote_media", "");
     settings->setDefault("debug_log_level", "action");
@@ -31,9 +31,7 @@ class DummyMap : public Map
 		for (s16 y = bpmin.Y; y <= bpmax.Y; y++) {
 			MapBlock *block = getBlockNoCreateNoEx({x, y, z});
 			if (block) {
-				auto *data = block->getData();
-				for (size_t i = 0; i < MapBlock::nodecount; i++)
-					data[i] = n;
+				block->fill(n);
 				block->expireIsAirCache();
 			}
 		}
@@ -33,6 +33,7 @@ Map::~Map()
 	/*
 		Free all MapSectors
 	*/
+	m_block_index.clear();
 	for (auto &sector : m_sectors) {
 		delete sector.second;
 	}
@@ -83,12 +84,7 @@ MapSector *Map::getSectorNoGenerate(v2s16 p)
 
 MapBlock *Map::getBlockNoCreateNoEx(v3s16 p3d)
 {
-	v2s16 p2d(p3d.X, p3d.Z);
-	MapSector *sector = getSectorNoGenerate(p2d);
-	if (!sector)
-		return nullptr;
-	MapBlock *block = sector->getBlockNoCreateNoEx(p3d.Y);
-	return block;
+	return m_block_index.get(p3d);
 }
 
 MapBlock *Map::getBlockNoCreate(v3s16 p3d)
@@ -149,15 +145,11 @@ void Map::setNode(v3s16 p, MapNode n)
 	set_node_in_block(m_gamedef->ndef(), block, relpos, n);
 }
 
-void Map::addNodeAndUpdate(v3s16 p, MapNode n,
-		std::map<v3s16, MapBlock*> &modified_blocks,
-		bool remove_metadata)
+void Map::setNodeForUpdate(v3s16 p, MapBlock *block, MapNode n,
+		std::map<v3s16, MapBlock*> &modified_blocks, bool remove_metadata,
+		std::vector<std::pair<v3s16, MapNode>> &light_changes)
 {
-	// Collect old node for rollback
-	RollbackNode rollback_oldnode(this, p, m_gamedef);
-
-	v3s16 blockpos = getNodeBlockPos(p);
-	MapBlock *block = getBlockNoCreate(blockpos);
+	v3s16 blockpos = block->getPos();
 	v3s16 relpos = p - blockpos * MAP_BLOCKSIZE;
 
 	// This is needed for updating the lighting
@@ -184,15 +176,29 @@ void Map::addNodeAndUpdate(v3s16 p, MapNode n,
 		n.setLight(LIGHTBANK_NIGHT, 0, f);
 		set_node_in_block(m_gamedef->ndef(), block, relpos, n);
 
-		// Update lighting
-		std::vector<std::pair<v3s16, MapNode> > oldnodes;
-		oldnodes.emplace_back(p, oldnode);
-		voxalgo::update_lighting_nodes(this, oldnodes, modified_blocks);
+		light_changes.emplace_back(p, oldnode);
 	}
 
 	if (n.getContent() != oldnode.getContent() &&
 			(oldnode.getContent() == CONTENT_AIR || n.getContent() == CONTENT_AIR))
 		block->expireIsAirCache();
+}
+
+void Map::addNodeAndUpdate(v3s16 p, MapNode n,
+		std::map<v3s16, MapBlock*> &modified_blocks,
+		bool remove_metadata)
+{
+	// Collect old node for rollback
+	RollbackNode rollback_oldnode(this, p, m_gamedef);
+
+	MapBlock *block = getBlockNoCreate(getNodeBlockPos(p));
+
+	std::vector<std::pair<v3s16, MapNode> > oldnodes;
+	setNodeForUpdate(p, block, n, modified_blocks, remove_metadata, oldnodes);
+
+	// Update lighting
+	if (!oldnodes.empty())
+		voxalgo::update_lighting_nodes(this, oldnodes, modified_blocks);
 
 	// Report for rollback
 	if(m_gamedef->rollback())
@@ -204,6 +210,40 @@ void Map::addNodeAndUpdate(v3s16 p, MapNode n,
 	}
 }
 
+bool Map::addNodesAndUpdate(const std::vector<v3s16> &positions, MapNode n,
+		std::map<v3s16, MapBlock*> &modified_blocks,
+		bool remove_metadata)
+{
+	bool succeeded = true;
+	IRollbackManager *rollback = m_gamedef->rollback();
+	std::vector<std::pair<v3s16, RollbackNode>> rollback_oldnodes;
+	std::vector<std::pair<v3s16, MapNode>> oldnodes;
+
+	for (v3s16 p : positions) {
+		MapBlock *block = getBlockNoCreateNoEx(getNodeBlockPos(p));
+		if (!block) {
+			succeeded = false;
+			continue;
+		}
+		if (rollback)
+			rollback_oldnodes.emplace_back(p, RollbackNode(this, p, m_gamedef));
+		setNodeForUpdate(p, block, n, modified_blocks, remove_metadata, oldnodes);
+	}
+
+	// One lighting update for all of them
+	if (!oldnodes.empty())
+		voxalgo::update_lighting_nodes(this, oldnodes, modified_blocks);
+
+	for (const auto &it : rollback_oldnodes) {
+		RollbackNode rollback_newnode(this, it.first, m_gamedef);
+		RollbackAction action;
+		action.setSetNode(it.first, it.second, rollback_newnode);
+		rollback->reportAction(action);
+	}
+
+	return succeeded;
+}
+
 void Map::removeNodeAndUpdate(v3s16 p,
 		std::map<v3s16, MapBlock*> &modified_blocks)
 {
@@ -274,7 +314,7 @@ struct TimeOrderedMapBlock {
 	Updates usage timers
 */
 void Map::timerUpdate(float dtime, float unload_timeout, s32 max_loaded_blocks,
-		std::vector<v3s16> *unloaded_blocks)
+		std::vector<v3s16> *unloaded_blocks, float compress_timeout)
 {
 	bool save_before_unloading = maySaveBlocks();
 
@@ -285,6 +325,7 @@ void Map::timerUpdate(float dtime, float unload_timeout, s32 max_loaded_blocks,
 	u32 deleted_blocks_count = 0;
 	u32 saved_blocks_count = 0;
 	u32 block_count_all = 0;
+	u32 compressed_blocks_count = 0;
 	u32 locked_blocks = 0;
 
 	const auto start_time = porting::getTimeUs();
@@ -327,6 +368,12 @@ void Map::timerUpdate(float dtime, float unload_timeout, s32 max_loaded_blocks,
 				} else {
 					all_blocks_deleted = false;
 					block_count_all++;
+
+					if (compress_timeout >= 0
+							&& block->getUsageTimer() > compress_timeout)
+						block->compressNodes();
+					if (block->isCompressed())
+						compressed_blocks_count++;
 				}
 			}
 
@@ -361,6 +408,8 @@ void Map::timerUpdate(float dtime, float unload_timeout, s32 max_loaded_blocks,
 
 			if (block->refGet() != 0) {
 				locked_blocks++;
+				if (block->isCompressed())
+					compressed_blocks_count++;
 				continue;
 			}
 
@@ -369,8 +418,11 @@ void Map::timerUpdate(float dtime, float unload_timeout, s32 max_loaded_blocks,
 			// Save if modified
 			if (block->getModified() != MOD_STATE_CLEAN && save_before_unloading) {
 				modprofiler.add(block->getModifiedReasonString(), 1);
-				if (!saveBlock(block))
+				if (!saveBlock(block)) {
+					if (block->isCompressed())
+						compressed_blocks_count++;
 					continue;
+				}
 				saved_blocks_count++;
 			}
 
@@ -384,6 +436,17 @@ void Map::timerUpdate(float dtime, float unload_timeout, s32 max_loaded_blocks,
 			block_count_all--;
 		}
 
+		// Compress the idle blocks that stay loaded
+		while (!mapblock_queue.empty()) {
+			MapBlock *block = mapblock_queue.top().block;
+			mapblock_queue.pop();
+			if (compress_timeout >= 0
+					&& block->getUsageTimer() > compress_timeout)
+				block->compressNodes();
+			if (block->isCompressed())
+				compressed_blocks_count++;
+		}
+
 		// Delete empty sectors
 		for (auto &sector_it : m_sectors) {
 			if (sector_it.second->empty()) {
@@ -395,7 +458,8 @@ void Map::timerUpdate(float dtime, float unload_timeout, s32 max_loaded_blocks,
 	endSave();
 	const auto end_time = porting::getTimeUs();
 
-	reportMetrics(end_time - start_time, saved_blocks_count, block_count_all);
+	reportMetrics(end_time - start_time, saved_blocks_count, block_count_all,
+		compressed_blocks_count);
 
 	// Finally delete the empty sectors
 	deleteSectors(sector_deletion_queue);
@@ -747,6 +811,36 @@ bool Map::isBlockOccluded(v3s16 pos_relative, v3s16 cam_pos_nodes, bool simple_c
 	return true;
 }
 
+MapNode MapBlockCache::getNode(v3s16 p, bool *is_valid_position)
+{
+	v3s16 blockpos = getNodeBlockPos(p);
+	MapBlock *block = getBlockNoCreateNoEx(blockpos);
+	if (!block) {
+		if (is_valid_position)
+			*is_valid_position = false;
+		return {CONTENT_IGNORE};
+	}
+
+	if (is_valid_position)
+		*is_valid_position = true;
+	return block->getNodeNoCheck(p - blockpos * MAP_BLOCKSIZE);
+}
+
+void MapBlockCache::clear()
+{
+	for (Slot &slot : m_slots)
+		slot.valid = false;
+}
+
+void MapBlockCache::reportHitRate(const std::string &name)
+{
+	u32 total = m_hits + m_misses;
+	if (total == 0)
+		return;
+	g_profiler->avg(name, 100.0f * m_hits / total);
+	m_hits = m_misses = 0;
+}
+
 MMVManip::MMVManip(Map *map):
 		VoxelManipulator(),
 		m_map(map)
@@ -845,6 +939,24 @@ std::map<v3s16, bool> MMVManip::getCoveredBlocks() const
 	return ret;
 }
 
+std::vector<v3s16> MMVManip::getChangedBlocks() const
+{
+	std::vector<v3s16> ret;
+	if (m_area.hasEmptyExtent())
+		return ret;
+	assert(m_map);
+
+	const auto covered_blocks = getCoveredBlocks();
+	for (auto &it : covered_blocks) {
+		if (!it.second)
+			continue;
+		MapBlock *block = m_map->getBlockNoCreateNoEx(it.first);
+		if (!block || block->differsFrom(*this))
+			ret.push_back(it.first);
+	}
+	return ret;
+}
+
 void MMVManip::blitBackAll(std::map<v3s16, MapBlock*> *modified_blocks,
 	bool overwrite_generated) const
 {
@@ -875,7 +987,8 @@ void MMVManip::blitBackAll(std::map<v3s16, MapBlock*> *modified_blocks,
 		if (!overwrite_generated && block->isGenerated())
 			continue;
 
-		block->copyFrom(*this);
+		if (!block->copyFrom(*this))
+			continue;
 		block->raiseModified(MOD_STATE_WRITE_NEEDED, MOD_REASON_VMANIP);
 		block->expireIsAirCache();
 
@@ -907,6 +1020,18 @@ MMVManip *MMVManip::clone() const
 	return ret;
 }
 
+MMVManip *MMVManip::takeContents()
+{
+	MMVManip *ret = new MMVManip();
+
+	std::swap(ret->m_area, m_area);
+	std::swap(ret->m_data, m_data);
+	std::swap(ret->m_flags, m_flags);
+	ret->m_is_dirty = m_is_dirty;
+
+	return ret;
+}
+
 void MMVManip::reparent(Map *map)
 {
 	assert(map && !m_map);
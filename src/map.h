@@ -10,6 +10,7 @@
 
 #include "irrlichttypes_bloated.h"
 #include "mapblock.h"
+#include "mapblockindex.h"
 #include "mapnode.h"
 #include "constants.h"
 #include "voxel.h"
@@ -153,6 +154,15 @@ class Map /*: public NodeContainer*/
 			bool remove_metadata = true);
 	void removeNodeAndUpdate(v3s16 p,
 			std::map<v3s16, MapBlock*> &modified_blocks);
+	/*
+		Same as addNodeAndUpdate() for many positions, but the lighting is
+		updated in one pass after all nodes are set.
+		Positions in blocks that do not exist are skipped.
+		Returns false if any position was skipped.
+	*/
+	virtual bool addNodesAndUpdate(const std::vector<v3s16> &positions,
+			MapNode n, std::map<v3s16, MapBlock*> &modified_blocks,
+			bool remove_metadata = true);
 
 	/*
 		Wrappers for the latter ones.
@@ -181,9 +191,11 @@ class Map /*: public NodeContainer*/
 	/*
 		Updates usage timers and unloads unused blocks and sectors.
 		Saves modified blocks before unloading if possible.
+		If compress_timeout >= 0, compresses the node data of blocks that are
+		kept but unused for longer than that (only without max_loaded_blocks).
 	*/
 	void timerUpdate(float dtime, float unload_timeout, s32 max_loaded_blocks,
-			std::vector<v3s16> *unloaded_blocks=NULL);
+			std::vector<v3s16> *unloaded_blocks=NULL, float compress_timeout=-1);
 
 	/*
 		Unloads all blocks with a zero refCount().
@@ -284,6 +296,10 @@ class Map /*: public NodeContainer*/
 
 	std::unordered_map<v2s16, MapSector*> m_sectors;
 
+	// All blocks of all sectors by position, kept up to date by MapSector
+	friend class MapSector;
+	MapBlockIndex m_block_index;
+
 	// Be sure to set this to NULL when the cached sector is deleted
 	MapSector *m_sector_cache = nullptr;
 	v2s16 m_sector_cache_p;
@@ -292,7 +308,14 @@ class Map /*: public NodeContainer*/
 	const NodeDefManager *m_nodedef;
 
 	// Can be implemented by child class
-	virtual void reportMetrics(u64 save_time_us, u32 saved_blocks, u32 all_blocks) {}
+	virtual void reportMetrics(u64 save_time_us, u32 saved_blocks, u32 all_blocks,
+		u32 compressed_blocks) {}
+
+	// Sets a node for addNodeAndUpdate() and addNodesAndUpdate(). If its
+	// lighting must be updated, the old node is added to light_changes.
+	void setNodeForUpdate(v3s16 p, MapBlock *block, MapNode n,
+		std::map<v3s16, MapBlock*> &modified_blocks, bool remove_metadata,
+		std::vector<std::pair<v3s16, MapNode>> &light_changes);
 
 	bool determineAdditionalOcclusionCheck(v3s16 pos_camera,
 		const core::aabbox3d<s16> &block_bounds, v3s16 &to_check);
@@ -301,6 +324,62 @@ class Map /*: public NodeContainer*/
 		u32 needed_count);
 };
 
+/*
+	Small direct-mapped cache of MapBlock pointers for algorithms that touch
+	many nodes in a small area (liquids, lighting). Each block position maps
+	to one slot of a 3x3x3 window, so any block and its direct neighbors can
+	be cached at the same time. Missing blocks are cached too.
+
+	The cache does not notice blocks being loaded or removed: clear() it
+	whenever that may have happened (e.g. after calling into Lua).
+*/
+class MapBlockCache
+{
+public:
+	MapBlockCache(Map *map) : m_map(map) {}
+
+	MapBlock *getBlockNoCreateNoEx(v3s16 blockpos)
+	{
+		Slot &slot = m_slots[slotIndex(blockpos)];
+		if (slot.valid && slot.pos == blockpos) {
+			m_hits++;
+			return slot.block;
+		}
+		m_misses++;
+		slot.pos = blockpos;
+		slot.block = m_map->getBlockNoCreateNoEx(blockpos);
+		slot.valid = true;
+		return slot.block;
+	}
+
+	// Same as Map::getNode()
+	MapNode getNode(v3s16 p, bool *is_valid_position = nullptr);
+
+	void clear();
+
+	// Reports the hit rate of the lookups since the last report to g_profiler
+	void reportHitRate(const std::string &name);
+
+private:
+	struct Slot {
+		v3s16 pos;
+		MapBlock *block = nullptr;
+		bool valid = false;
+	};
+
+	static inline u16 slotIndex(v3s16 p)
+	{
+		// Non-negative modulo, so neighboring blocks never share a slot
+		auto mod3 = [] (s16 v) -> u16 { return ((v % 3) + 3) % 3; };
+		return mod3(p.X) + 3 * mod3(p.Y) + 9 * mod3(p.Z);
+	}
+
+	Map *m_map;
+	Slot m_slots[27];
+	u32 m_hits = 0;
+	u32 m_misses = 0;
+};
+
 class MMVManip : public VoxelManipulator
 {
 public:
@@ -322,12 +401,21 @@ class MMVManip : public VoxelManipulator
 	*/
 	std::map<v3s16, bool> getCoveredBlocks() const;
 
+	/**
+		Compares the data in VManip with the map.
+		Blocks without any data in the VManip and CONTENT_IGNORE nodes are
+		skipped, same as in blitBackAll.
+		@warning requires VManip area to be block-aligned
+		@return positions of blocks that differ or are not loaded in the map
+	*/
+	std::vector<v3s16> getChangedBlocks() const;
+
 	/**
 		Writes data in VManip back to the map. Blocks without any data in the VManip
-		are skipped.
+		are skipped, as are blocks whose data did not change.
 		@note VOXELFLAG_NO_DATA is checked per-block, not per-node. So you need
 		to ensure that the relevant parts of m_data are initialized.
-		@param modified_blocks output array of touched blocks (optional)
+		@param modified_blocks output array of changed blocks (optional)
 		@param overwrite_generated if false, blocks marked as generate in the map are not changed
 	*/
 	void blitBackAll(std::map<v3s16, MapBlock*> * modified_blocks,
@@ -339,6 +427,12 @@ class MMVManip : public VoxelManipulator
 	*/
 	MMVManip *clone() const;
 
+	/*
+		Like clone(), but moves the contents into the new VManip instead of
+		copying them. This one is left empty.
+	*/
+	MMVManip *takeContents();
+
 	// Reassociates a copied VManip to a map
 	void reparent(Map *map);
 
@@ -4,6 +4,7 @@
 
 #include "mapblock.h"
 
+#include <algorithm>
 #include <sstream>
 #include "map.h"
 #include "light.h"
@@ -99,10 +100,31 @@ static const char *modified_reason_strings[] = {
 	MapBlock
 */
 
+struct MapBlock::CompressedNodes
+{
+	// Most blocks that are uniform enough to be worth it fit in here
+	static constexpr size_t max_palette_size = 16;
+
+	// Distinct nodes of the block
+	std::vector<MapNode> palette;
+	// Bits per palette index: 0 (single node), 1, 2 or 4
+	u8 bits = 0;
+	// Bit-packed palette indices, empty if bits == 0
+	std::vector<u8> indices;
+
+	inline MapNode get(u32 i) const
+	{
+		if (bits == 0)
+			return palette[0];
+		const u32 bit = i * bits;
+		return palette[(indices[bit / 8] >> (bit % 8)) & ((1 << bits) - 1)];
+	}
+};
+
 MapBlock::MapBlock(v3s16 pos, IGameDef *gamedef):
 		m_pos(pos),
 		m_pos_relative(pos * MAP_BLOCKSIZE),
-		data(new MapNode[nodecount]),
+		m_content(new content_t[nodecount * 2]),
 		m_gamedef(gamedef)
 {
 	reallocate();
@@ -118,8 +140,10 @@ MapBlock::~MapBlock()
 	}
 #endif
 
-	delete[] data;
-	porting::TrackFreedMemory(sizeof(MapNode) * nodecount);
+	if (m_content) {
+		delete[] m_content;
+		porting::TrackFreedMemory(sizeof(content_t) * 2 * nodecount);
+	}
 }
 
 static inline size_t get_max_objects_per_block()
@@ -172,7 +196,17 @@ bool MapBlock::saveStaticObject(u16 id, const StaticObject &obj, u32 reason)
 void MapBlock::step(float dtime, const std::function<bool(v3s16, MapNode, f32)> &on_timer_cb)
 {
 	// Run callbacks for elapsed node_timers
-	std::vector<NodeTimer> elapsed_timers = m_node_timers.step(dtime);
+	runNodeTimers(m_node_timers.step(dtime), on_timer_cb);
+}
+
+void MapBlock::runDueNodeTimers(const std::function<bool(v3s16, MapNode, f32)> &on_timer_cb)
+{
+	runNodeTimers(m_node_timers.popElapsed(), on_timer_cb);
+}
+
+void MapBlock::runNodeTimers(const std::vector<NodeTimer> &elapsed_timers,
+	const std::function<bool(v3s16, MapNode, f32)> &on_timer_cb)
+{
 	MapNode n;
 	v3s16 p;
 	for (const auto &it : elapsed_timers) {
@@ -209,22 +243,88 @@ std::string MapBlock::getModifiedReasonString()
 
 void MapBlock::copyTo(VoxelManipulator &dst)
 {
-	v3s16 data_size(MAP_BLOCKSIZE, MAP_BLOCKSIZE, MAP_BLOCKSIZE);
-	VoxelArea data_area(v3s16(0,0,0), data_size - v3s16(1,1,1));
+	const v3s16 pos = getPosRelative();
+
+	// Copy from data to VoxelManipulator, row by row
+	u32 i = 0;
+	for (s16 z = 0; z < MAP_BLOCKSIZE; z++)
+	for (s16 y = 0; y < MAP_BLOCKSIZE; y++) {
+		const u32 i_dst = dst.m_area.index(pos.X, pos.Y + y, pos.Z + z);
+		for (u32 x = 0; x < MAP_BLOCKSIZE; x++, i++)
+			dst.m_data[i_dst + x] = getNodeAt(i);
+		memset(&dst.m_flags[i_dst], 0, MAP_BLOCKSIZE);
+	}
+}
 
-	// Copy from data to VoxelManipulator
-	dst.copyFrom(data, data_area, v3s16(0,0,0),
-			getPosRelative(), data_size);
+bool MapBlock::copyFrom(const VoxelManipulator &src)
+{
+	const v3s16 pos = getPosRelative();
+	bool changed = false;
+
+	// Copy from VoxelManipulator to data, skipping CONTENT_IGNORE.
+	// Nodes are compared until the first difference, so that blocks which
+	// did not change are neither decompressed nor written to.
+	u32 i = 0;
+	for (s16 z = 0; z < MAP_BLOCKSIZE; z++)
+	for (s16 y = 0; y < MAP_BLOCKSIZE; y++) {
+		const u32 i_src = src.m_area.index(pos.X, pos.Y + y, pos.Z + z);
+		for (u32 x = 0; x < MAP_BLOCKSIZE; x++, i++) {
+			const MapNode &n = src.m_data[i_src + x];
+			if (n.getContent() == CONTENT_IGNORE)
+				continue;
+			if (!changed) {
+				if (getNodeAt(i) == n)
+					continue;
+				changed = true;
+				if (!m_content)
+					decompressNodes();
+			}
+			m_content[i] = n.getContent();
+			param1Data()[i] = n.getParam1();
+			param2Data()[i] = n.getParam2();
+		}
+	}
+	return changed;
 }
 
-void MapBlock::copyFrom(const VoxelManipulator &src)
+bool MapBlock::differsFrom(const VoxelManipulator &src) const
 {
-	v3s16 data_size(MAP_BLOCKSIZE, MAP_BLOCKSIZE, MAP_BLOCKSIZE);
-	VoxelArea data_area(v3s16(0,0,0), data_size - v3s16(1,1,1));
+	const v3s16 pos = getPosRelative();
+
+	u32 i = 0;
+	for (s16 z = 0; z < MAP_BLOCKSIZE; z++)
+	for (s16 y = 0; y < MAP_BLOCKSIZE; y++) {
+		const u32 i_src = src.m_area.index(pos.X, pos.Y + y, pos.Z + z);
+		for (u32 x = 0; x < MAP_BLOCKSIZE; x++, i++) {
+			const MapNode &n = src.m_data[i_src + x];
+			if (n.getContent() != CONTENT_IGNORE && !(getNodeAt(i) == n))
+				return true;
+		}
+	}
+	return false;
+}
+
+void MapBlock::copyNodesTo(MapNode *dst) const
+{
+	for (u32 i = 0; i < nodecount; i++)
+		dst[i] = getNodeAt(i);
+}
+
+void MapBlock::copyNodesFrom(const MapNode *src)
+{
+	for (u32 i = 0; i < nodecount; i++)
+		setNodeAt(i, src[i]);
+	raiseModified(MOD_STATE_WRITE_NEEDED, MOD_REASON_SET_NODE);
+}
+
+void MapBlock::fillNodes(MapNode n)
+{
+	if (!m_content)
+		decompressNodes();
 
-	// Copy from VoxelManipulator to data
-	src.copyTo(data, data_area, v3s16(0,0,0),
-			getPosRelative(), data_size);
+	std::fill_n(m_content, nodecount, n.getContent());
+	memset(param1Data(), n.getParam1(), nodecount);
+	memset(param2Data(), n.getParam2(), nodecount);
 }
 
 void MapBlock::actuallyUpdateIsAir()
@@ -233,11 +333,19 @@ void MapBlock::actuallyUpdateIsAir()
 	m_is_air_expired = false;
 
 	bool only_air = true;
-	for (u32 i = 0; i < nodecount; i++) {
-		MapNode &n = data[i];
-		if (n.getContent() != CONTENT_AIR) {
-			only_air = false;
-			break;
+	if (m_compressed) {
+		for (MapNode n : m_compressed->palette) {
+			if (n.getContent() != CONTENT_AIR) {
+				only_air = false;
+				break;
+			}
+		}
+	} else {
+		for (u32 i = 0; i < nodecount; i++) {
+			if (m_content[i] != CONTENT_AIR) {
+				only_air = false;
+				break;
+			}
 		}
 	}
 
@@ -250,6 +358,92 @@ void MapBlock::expireIsAirCache()
 	m_is_air_expired = true;
 }
 
+/*
+	Node data compression
+*/
+
+bool MapBlock::compressNodes()
+{
+	if (!m_content)
+		return true;
+	if (m_nodes_incompressible)
+		return false;
+
+	const u8 *param1 = param1Data();
+	const u8 *param2 = param2Data();
+
+	auto compressed = std::make_unique<CompressedNodes>();
+	auto &palette = compressed->palette;
+	u8 index[nodecount];
+	u8 last = 0;
+	palette.push_back(getNodeAt(0));
+	for (u32 i = 0; i < nodecount; i++) {
+		const MapNode n(m_content[i], param1[i], param2[i]);
+		// Runs of the same node are common
+		if (!(palette[last] == n)) {
+			auto it = std::find(palette.begin(), palette.end(), n);
+			if (it == palette.end()) {
+				if (palette.size() == CompressedNodes::max_palette_size) {
+					m_nodes_incompressible = true;
+					return false;
+				}
+				palette.push_back(n);
+				it = palette.end() - 1;
+			}
+			last = it - palette.begin();
+		}
+		index[i] = last;
+	}
+	palette.shrink_to_fit();
+
+	u8 bits = 4;
+	if (palette.size() == 1)
+		bits = 0;
+	else if (palette.size() <= 2)
+		bits = 1;
+	else if (palette.size() <= 4)
+		bits = 2;
+	compressed->bits = bits;
+	if (bits > 0) {
+		compressed->indices.resize(nodecount * bits / 8);
+		for (u32 i = 0; i < nodecount; i++) {
+			const u32 bit = i * bits;
+			compressed->indices[bit / 8] |= index[i] << (bit % 8);
+		}
+	}
+
+	delete[] m_content;
+	m_content = nullptr;
+	porting::TrackFreedMemory(sizeof(content_t) * 2 * nodecount);
+	m_compressed = std::move(compressed);
+	return true;
+}
+
+MapNode MapBlock::getCompressedNodeAt(u32 i) const
+{
+	return m_compressed->get(i);
+}
+
+void MapBlock::decodeCompressedNodes(content_t *dst) const
+{
+	u8 *param1 = reinterpret_cast<u8 *>(dst + nodecount);
+	u8 *param2 = param1 + nodecount;
+	for (u32 i = 0; i < nodecount; i++) {
+		const MapNode n = m_compressed->get(i);
+		dst[i] = n.getContent();
+		param1[i] = n.getParam1();
+		param2[i] = n.getParam2();
+	}
+}
+
+void MapBlock::decompressNodes()
+{
+	assert(m_compressed);
+	m_content = new content_t[nodecount * 2];
+	decodeCompressedNodes(m_content);
+	m_compressed.reset();
+}
+
 /*
 	Serialization
 */
@@ -258,14 +452,14 @@ void MapBlock::expireIsAirCache()
 // Renumbers the content IDs (starting at 0 and incrementing)
 // Note that there's no technical reason why we *have to* renumber the IDs,
 // but we do it anyway as it also helps compressability.
-static void getBlockNodeIdMapping(NameIdMapping *nimap, MapNode *nodes,
+static void getBlockNodeIdMapping(NameIdMapping *nimap, content_t *contents,
 	const NodeDefManager *nodedef)
 {
 	IdIdMapping &mapping = IdIdMapping::giveClearedThreadLocalInstance();
 
 	content_t id_counter = 0;
 	for (u32 i = 0; i < MapBlock::nodecount; i++) {
-		content_t global_id = nodes[i].getContent();
+		content_t global_id = contents[i];
 		content_t id = CONTENT_IGNORE;
 
 		// Try to find an existing mapping
@@ -280,15 +474,15 @@ static void getBlockNodeIdMapping(NameIdMapping *nimap, MapNode *nodes,
 			nimap->set(id, name);
 		}
 
-		// Update the MapNode
-		nodes[i].setContent(id);
+		// Update the content
+		contents[i] = id;
 	}
 }
 
 // Correct ids in the block to match nodedef based on names.
 // Unknown ones are added to nodedef.
 // Will not update itself to match id-name pairs in nodedef.
-static void correctBlockNodeIds(const NameIdMapping *nimap, MapNode *nodes,
+static void correctBlockNodeIds(const NameIdMapping *nimap, content_t *contents,
 		IGameDef *gamedef)
 {
 	const NodeDefManager *nodedef = gamedef->ndef();
@@ -303,10 +497,10 @@ static void correctBlockNodeIds(const NameIdMapping *nimap, MapNode *nodes,
 	IdIdMapping &mapping_cache = IdIdMapping::giveClearedThreadLocalInstance();
 
 	for (u32 i = 0; i < MapBlock::nodecount; i++) {
-		content_t local_id = nodes[i].getContent();
+		content_t local_id = contents[i];
 
 		if (auto found = mapping_cache.get(local_id); found != 0xFFFF) {
-			nodes[i].setContent(found);
+			contents[i] = found;
 			continue;
 		}
 
@@ -324,7 +518,7 @@ static void correctBlockNodeIds(const NameIdMapping *nimap, MapNode *nodes,
 				continue;
 			}
 		}
-		nodes[i].setContent(global_id);
+		contents[i] = global_id;
 
 		// Save previous node local_id & global_id result
 		mapping_cache.set(local_id, global_id);
@@ -342,6 +536,52 @@ static void correctBlockNodeIds(const NameIdMapping *nimap, MapNode *nodes,
 	}
 }
 
+// Writes the node arrays in the format of MapNode::serializeBulk
+static Buffer<u8> serializeNodes(const content_t *contents, const u8 *param1,
+		const u8 *param2)
+{
+	constexpr u32 nodecount = MapBlock::nodecount;
+	Buffer<u8> databuf(nodecount * 4);
+
+	u8 *p = &databuf[0];
+	for (u32 i = 0; i < nodecount; i++, p += 2)
+		writeU16(p, contents[i]);
+	memcpy(p, param1, nodecount);
+	memcpy(p + nodecount, param2, nodecount);
+
+	return databuf;
+}
+
+// Reads the node arrays in the format of MapNode::deSerializeBulk
+static void deSerializeNodes(std::istream &is, u8 content_width,
+		content_t *contents, u8 *param1, u8 *param2)
+{
+	constexpr u32 nodecount = MapBlock::nodecount;
+	const u32 len = nodecount * (content_width + 2);
+	Buffer<u8> databuf(len);
+	is.read(reinterpret_cast<char*>(*databuf), len);
+
+	if (content_width == 1) {
+		for (u32 i = 0; i < nodecount; i++)
+			contents[i] = readU8(&databuf[i]);
+	} else {
+		for (u32 i = 0; i < nodecount; i++)
+			contents[i] = readU16(&databuf[i * 2]);
+	}
+	memcpy(param1, &databuf[content_width * nodecount], nodecount);
+	memcpy(param2, &databuf[(content_width + 1) * nodecount], nodecount);
+
+	if (content_width == 1) {
+		for (u32 i = 0; i < nodecount; i++) {
+			if (contents[i] > 0x7F) {
+				contents[i] <<= 4;
+				contents[i] |= (param2[i] & 0xF0) >> 4;
+				param2[i] &= 0x0F;
+			}
+		}
+	}
+}
+
 void MapBlock::serialize(std::ostream &os_compressed, u8 version, bool disk, int compression_level)
 {
 	if (!ser_ver_supported_write(version))
@@ -375,15 +615,24 @@ void MapBlock::serialize(std::ostream &os_compressed, u8 version, bool disk, int
 	Buffer<u8> buf;
 	const u8 content_width = 2;
 	const u8 params_width = 2;
+	// Compressed node data is decoded into a temporary buffer
+	std::unique_ptr<content_t[]> decoded;
+	const content_t *contents = m_content;
+	if (m_compressed) {
+		decoded.reset(new content_t[nodecount * 2]);
+		decodeCompressedNodes(decoded.get());
+		contents = decoded.get();
+	}
+	const u8 *param1 = reinterpret_cast<const u8 *>(contents + nodecount);
+	const u8 *param2 = param1 + nodecount;
 	if(disk)
 	{
-		MapNode *tmp_nodes = new MapNode[nodecount];
-		memcpy(tmp_nodes, data, nodecount * sizeof(MapNode));
-		getBlockNodeIdMapping(&nimap, tmp_nodes, m_gamedef->ndef());
+		content_t *tmp_contents = new content_t[nodecount];
+		memcpy(tmp_contents, contents, nodecount * sizeof(content_t));
+		getBlockNodeIdMapping(&nimap, tmp_contents, m_gamedef->ndef());
 
-		buf = MapNode::serializeBulk(version, tmp_nodes, nodecount,
-				content_width, params_width);
-		delete[] tmp_nodes;
+		buf = serializeNodes(tmp_contents, param1, param2);
+		delete[] tmp_contents;
 
 		// write timestamp and node/id mapping first
 		if (version >= 29) {
@@ -394,8 +643,7 @@ void MapBlock::serialize(std::ostream &os_compressed, u8 version, bool disk, int
 	}
 	else
 	{
-		buf = MapNode::serializeBulk(version, data, nodecount,
-				content_width, params_width);
+		buf = serializeNodes(contents, param1, param2);
 	}
 
 	writeU8(os, content_width);
@@ -463,6 +711,8 @@ void MapBlock::deSerialize(std::istream &in_compressed, u8 version, bool disk)
 
 	TRACESTREAM(<<"MapBlock::deSerialize "<<getPos()<<std::endl);
 
+	if (!m_content)
+		decompressNodes();
 	m_is_air_expired = true;
 
 	if(version <= 21)
@@ -515,13 +765,13 @@ void MapBlock::deSerialize(std::istream &in_compressed, u8 version, bool disk)
 		Bulk node data
 	*/
 	if (version >= 29) {
-		MapNode::deSerializeBulk(is, version, data, nodecount,
-			content_width, params_width);
+		deSerializeNodes(is, content_width, m_content,
+			param1Data(), param2Data());
 	} else {
 		// use in_raw from above to avoid allocating another stream object
 		decompress(is, in_raw, version);
-		MapNode::deSerializeBulk(in_raw, version, data, nodecount,
-			content_width, params_width);
+		deSerializeNodes(in_raw, content_width, m_content,
+			param1Data(), param2Data());
 	}
 
 	/*
@@ -584,7 +834,7 @@ void MapBlock::deSerialize(std::istream &in_compressed, u8 version, bool disk)
 		}
 
 		// Dynamically re-set ids based on node names
-		correctBlockNodeIds(&nimap, data, m_gamedef);
+		correctBlockNodeIds(&nimap, m_content, m_gamedef);
 
 		if(version >= 25){
 			TRACESTREAM(<<"MapBlock::deSerialize "<<getPos()
@@ -757,7 +1007,9 @@ void MapBlock::deSerialize_pre22(std::istream &is, u8 version, bool disk)
 
 	// Deserialize node data
 	for (u32 i = 0; i < nodecount; i++) {
-		data[i].deSerialize(&databuf_nodelist[i * ser_length], version);
+		MapNode n;
+		n.deSerialize(&databuf_nodelist[i * ser_length], version);
+		setNodeAt(i, n);
 	}
 
 	if (disk) {
@@ -801,36 +1053,38 @@ void MapBlock::deSerialize_pre22(std::istream &is, u8 version, bool disk)
 			m_is_air = false;
 			m_is_air_expired = true;
 		}
-		correctBlockNodeIds(&nimap, data, m_gamedef);
+		correctBlockNodeIds(&nimap, m_content, m_gamedef);
 	}
 
 	// Legacy data changes
 	// This code has to convert from pre-22 to post-22 format.
 	const NodeDefManager *nodedef = m_gamedef->ndef();
+	u8 *param1 = param1Data();
+	u8 *param2 = param2Data();
 	for (u32 i = 0; i < nodecount; i++) {
-		const ContentFeatures &f = nodedef->get(data[i].getContent());
+		const ContentFeatures &f = nodedef->get(m_content[i]);
 		// Mineral
-		if(nodedef->getId("default:stone") == data[i].getContent()
-				&& data[i].getParam1() == 1)
+		if(nodedef->getId("default:stone") == m_content[i]
+				&& param1[i] == 1)
 		{
-			data[i].setContent(nodedef->getId("default:stone_with_coal"));
-			data[i].setParam1(0);
+			m_content[i] = nodedef->getId("default:stone_with_coal");
+			param1[i] = 0;
 		}
-		else if(nodedef->getId("default:stone") == data[i].getContent()
-				&& data[i].getParam1() == 2)
+		else if(nodedef->getId("default:stone") == m_content[i]
+				&& param1[i] == 2)
 		{
-			data[i].setContent(nodedef->getId("default:stone_with_iron"));
-			data[i].setParam1(0);
+			m_content[i] = nodedef->getId("default:stone_with_iron");
+			param1[i] = 0;
 		}
 		// facedir_simple
 		if (f.legacy_facedir_simple) {
-			data[i].setParam2(data[i].getParam1());
-			data[i].setParam1(0);
+			param2[i] = param1[i];
+			param1[i] = 0;
 		}
 		// wall_mounted
 		if (f.legacy_wallmounted) {
 			u8 wallmounted_new_to_old[8] = {0x04, 0x08, 0x01, 0x02, 0x10, 0x20, 0, 0};
-			u8 dir_old_format = data[i].getParam2();
+			u8 dir_old_format = param2[i];
 			u8 dir_new_format = 0;
 			for (u8 j = 0; j < 8; j++) {
 				if ((dir_old_format & wallmounted_new_to_old[j]) != 0) {
@@ -838,7 +1092,7 @@ void MapBlock::deSerialize_pre22(std::istream &is, u8 version, bool disk)
 					break;
 				}
 			}
-			data[i].setParam2(dir_new_format);
+			param2[i] = dir_new_format;
 		}
 	}
 }
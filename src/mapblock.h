@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 #include "irr_v3d.h"
 #include "mapnode.h"
@@ -75,16 +76,10 @@ class MapBlock
 
 	void reallocate()
 	{
-		for (u32 i = 0; i < nodecount; i++)
-			data[i] = MapNode(CONTENT_IGNORE);
+		fillNodes(MapNode(CONTENT_IGNORE));
 		raiseModified(MOD_STATE_WRITE_NEEDED, MOD_REASON_REALLOCATE);
 	}
 
-	MapNode* getData()
-	{
-		return data;
-	}
-
 	////
 	//// Modification tracking methods
 	////
@@ -98,8 +93,10 @@ class MapBlock
 		} else if (mod == m_modified) {
 			m_modified_reason |= reason;
 		}
-		if (mod == MOD_STATE_WRITE_NEEDED)
+		if (mod == MOD_STATE_WRITE_NEEDED) {
 			contents.clear();
+			m_nodes_incompressible = false;
+		}
 	}
 
 	inline u32 getModified()
@@ -196,7 +193,7 @@ class MapBlock
 		return m_pos;
 	}
 
-	inline v3s16 getPosRelative()
+	inline v3s16 getPosRelative() const
 	{
 		return m_pos_relative;
 	}
@@ -236,7 +233,7 @@ class MapBlock
 		if (!*valid_position)
 			return {CONTENT_IGNORE};
 
-		return data[z * zstride + y * ystride + x];
+		return getNodeAt(z * zstride + y * ystride + x);
 	}
 
 	inline MapNode getNode(v3s16 p, bool *valid_position)
@@ -255,7 +252,7 @@ class MapBlock
 		if (!isValidPosition(x, y, z))
 			throw InvalidPositionException();
 
-		data[z * zstride + y * ystride + x] = n;
+		setNodeAt(z * zstride + y * ystride + x, n);
 		raiseModified(MOD_STATE_WRITE_NEEDED, MOD_REASON_SET_NODE);
 	}
 
@@ -270,7 +267,7 @@ class MapBlock
 
 	inline MapNode getNodeNoCheck(s16 x, s16 y, s16 z)
 	{
-		return data[z * zstride + y * ystride + x];
+		return getNodeAt(z * zstride + y * ystride + x);
 	}
 
 	inline MapNode getNodeNoCheck(v3s16 p)
@@ -280,7 +277,7 @@ class MapBlock
 
 	inline void setNodeNoCheck(s16 x, s16 y, s16 z, MapNode n)
 	{
-		data[z * zstride + y * ystride + x] = n;
+		setNodeAt(z * zstride + y * ystride + x, n);
 		raiseModified(MOD_STATE_WRITE_NEEDED, MOD_REASON_SET_NODE);
 	}
 
@@ -289,11 +286,73 @@ class MapBlock
 		setNodeNoCheck(p.X, p.Y, p.Z, n);
 	}
 
+	////
+	//// Bulk accessors
+	////
+
+	// The node fields are stored as separate arrays of `nodecount` elements,
+	// indexed by z * zstride + y * ystride + x. Scanners that only need the
+	// content should use these instead of reading whole MapNodes.
+	// Compressed node data is decompressed first.
+	inline const content_t *getContentData()
+	{
+		if (!m_content)
+			decompressNodes();
+		return m_content;
+	}
+
+	inline const u8 *getParam1Data()
+	{
+		if (!m_content)
+			decompressNodes();
+		return param1Data();
+	}
+
+	inline const u8 *getParam2Data()
+	{
+		if (!m_content)
+			decompressNodes();
+		return param2Data();
+	}
+
+	// Reads all nodes into `dst`, which holds `nodecount` elements
+	void copyNodesTo(MapNode *dst) const;
+
+	// Sets all nodes from `src`, which holds `nodecount` elements
+	void copyNodesFrom(const MapNode *src);
+
+	// Sets all nodes to `n`
+	void fill(MapNode n)
+	{
+		fillNodes(n);
+		raiseModified(MOD_STATE_WRITE_NEEDED, MOD_REASON_SET_NODE);
+	}
+
+	////
+	//// Node data compression
+	////
+
+	// Replaces the node data by a palette of its distinct nodes and
+	// bit-packed indices into it, if there are few enough distinct nodes.
+	// Reads work on the compressed data, writes and the bulk accessors
+	// decompress it again. Returns whether the node data is compressed.
+	bool compressNodes();
+
+	inline bool isCompressed() const
+	{
+		return !m_content;
+	}
+
 	// Copies data to VoxelManipulator to getPosRelative()
 	void copyTo(VoxelManipulator &dst);
 
 	// Copies data from VoxelManipulator to getPosRelative()
-	void copyFrom(const VoxelManipulator &src);
+	// Returns whether any node was changed
+	bool copyFrom(const VoxelManipulator &src);
+
+	// Checks whether the VoxelManipulator has data at getPosRelative()
+	// that is different from this block, ignoring CONTENT_IGNORE
+	bool differsFrom(const VoxelManipulator &src) const;
 
 	// Update is air flag.
 	// Sets m_is_air to appropriate value.
@@ -315,6 +374,8 @@ class MapBlock
 
 	/// @note This method is only for Server, don't call it on client
 	void step(float dtime, const std::function<bool(v3s16, MapNode, f32)> &on_timer_cb);
+	/// Like step(), for node timers attached to a scheduler
+	void runDueNodeTimers(const std::function<bool(v3s16, MapNode, f32)> &on_timer_cb);
 
 	////
 	//// Timestamp (see m_timestamp)
@@ -408,6 +469,22 @@ class MapBlock
 		m_node_timers.clear();
 	}
 
+	// Let the node timers follow the scheduler (while the block is active)
+	inline void attachNodeTimers(NodeTimerScheduler *scheduler)
+	{
+		m_node_timers.attach(scheduler, getPos());
+	}
+
+	inline void detachNodeTimers()
+	{
+		m_node_timers.detach();
+	}
+
+	inline bool nodeTimersAttached() const
+	{
+		return m_node_timers.isAttached();
+	}
+
 	////
 	//// Serialization
 	///
@@ -439,6 +516,44 @@ class MapBlock
 
 	void deSerialize_pre22(std::istream &is, u8 version, bool disk);
 
+	void runNodeTimers(const std::vector<NodeTimer> &elapsed_timers,
+		const std::function<bool(v3s16, MapNode, f32)> &on_timer_cb);
+
+	inline u8 *param1Data() const
+	{
+		return reinterpret_cast<u8 *>(m_content + nodecount);
+	}
+
+	inline u8 *param2Data() const
+	{
+		return param1Data() + nodecount;
+	}
+
+	inline MapNode getNodeAt(u32 i) const
+	{
+		if (!m_content)
+			return getCompressedNodeAt(i);
+		return MapNode(m_content[i], param1Data()[i], param2Data()[i]);
+	}
+
+	inline void setNodeAt(u32 i, MapNode n)
+	{
+		if (!m_content)
+			decompressNodes();
+		m_content[i] = n.getContent();
+		param1Data()[i] = n.getParam1();
+		param2Data()[i] = n.getParam2();
+	}
+
+	void fillNodes(MapNode n);
+
+	struct CompressedNodes;
+
+	MapNode getCompressedNodeAt(u32 i) const;
+	// Writes the nodes in the layout of m_content to `dst`
+	void decodeCompressedNodes(content_t *dst) const;
+	void decompressNodes();
+
 	/*
 	 * PLEASE NOTE: When adding something here be mindful of position and size
 	 * of member variables! This is also the reason for the weird public-private
@@ -476,11 +591,19 @@ class MapBlock
 	short m_refcount = 0;
 
 	/*
+	 * Node data as a structure of arrays: `nodecount` contents followed by
+	 * `nodecount` param1 and `nodecount` param2 values in the same allocation.
+	 * This is the layout of the serialization format, and content-only scans
+	 * don't pull the params into the cache.
 	 * Note that this is not an inline array because that has implications for
 	 * heap fragmentation (the array is exactly 16K), CPU caches and/or
 	 * optimizability of algorithms working on this array.
+	 * Null while the node data is compressed.
 	 */
-	MapNode *const data; // of `nodecount` elements
+	content_t *m_content;
+
+	// Node data of idle blocks, see compressNodes()
+	std::unique_ptr<CompressedNodes> m_compressed;
 
 	// provides the item and node definitions
 	IGameDef *m_gamedef;
@@ -506,6 +629,9 @@ class MapBlock
 	bool m_is_air = false;
 	bool m_is_air_expired = true;
 
+	// Whether compressNodes() failed since the last modification
+	bool m_nodes_incompressible = false;
+
 	/*
 		- On the server, this is used for telling whether the
 		  block has been modified from the one on disk.
@@ -0,0 +1,100 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2024 Luanti Authors
+
+#include "mapblockindex.h"
+#include <algorithm>
+#include <cassert>
+
+// Smallest table, must be a power of two
+static constexpr size_t MIN_CAPACITY = 64;
+
+void MapBlockIndex::set(v3s16 p, MapBlock *block)
+{
+	assert(block);
+	// Keep the load factor at or below 1/2
+	if ((m_count + 1) * 2 > m_slots.size())
+		rehash(std::max(MIN_CAPACITY, m_slots.size() * 2));
+
+	const u64 key = packKey(p);
+	for (size_t i = slotFor(key);; i = (i + 1) & m_mask) {
+		Slot &slot = m_slots[i];
+		if (!slot.block) {
+			slot.key = key;
+			slot.block = block;
+			m_count++;
+			return;
+		}
+		if (slot.key == key) {
+			slot.block = block;
+			return;
+		}
+	}
+}
+
+bool MapBlockIndex::remove(v3s16 p)
+{
+	if (m_count == 0)
+		return false;
+
+	const u64 key = packKey(p);
+	size_t i = slotFor(key);
+	for (;; i = (i + 1) & m_mask) {
+		if (!m_slots[i].block)
+			return false;
+		if (m_slots[i].key == key)
+			break;
+	}
+
+	// Backward shift deletion: move following entries of the probe sequence
+	// into the hole, so that no tombstones are needed.
+	for (size_t j = (i + 1) & m_mask;; j = (j + 1) & m_mask) {
+		Slot &slot = m_slots[j];
+		if (!slot.block)
+			break;
+		const size_t home = slotFor(slot.key);
+		// Entry can be moved if its home slot is not in (i, j]
+		if (((j - home) & m_mask) >= ((j - i) & m_mask)) {
+			m_slots[i] = slot;
+			i = j;
+		}
+	}
+	m_slots[i].block = nullptr;
+	m_count--;
+
+	// Shrink when mostly empty, e.g. after a lot of blocks were unloaded
+	if (m_slots.size() > MIN_CAPACITY && m_count * 8 < m_slots.size())
+		rehash(m_slots.size() / 2);
+	return true;
+}
+
+void MapBlockIndex::clear()
+{
+	m_slots.clear();
+	m_slots.shrink_to_fit();
+	m_mask = 0;
+	m_shift = 64;
+	m_count = 0;
+}
+
+void MapBlockIndex::rehash(size_t capacity)
+{
+	assert((capacity & (capacity - 1)) == 0);
+	std::vector<Slot> old;
+	old.swap(m_slots);
+
+	m_slots.resize(capacity, Slot{0, nullptr});
+	m_mask = capacity - 1;
+	m_shift = 64;
+	for (size_t c = capacity; c > 1; c >>= 1)
+		m_shift--;
+
+	for (const Slot &slot : old) {
+		if (!slot.block)
+			continue;
+		size_t i = slotFor(slot.key);
+		while (m_slots[i].block)
+			i = (i + 1) & m_mask;
+		m_slots[i] = slot;
+	}
+}
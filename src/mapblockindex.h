@@ -0,0 +1,72 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2024 Luanti Authors
+
+#pragma once
+
+#include "irrlichttypes.h"
+#include "irr_v3d.h"
+#include <vector>
+
+class MapBlock;
+
+/*
+	Flat hash table from block position to MapBlock, used by Map for block
+	lookups. Uses open addressing with linear probing, so a lookup is a
+	single hash and (usually) one cache line.
+	The blocks are not owned by the index.
+*/
+class MapBlockIndex
+{
+public:
+	MapBlockIndex() = default;
+
+	MapBlock *get(v3s16 p) const
+	{
+		if (m_count == 0)
+			return nullptr;
+		const u64 key = packKey(p);
+		for (size_t i = slotFor(key);; i = (i + 1) & m_mask) {
+			const Slot &slot = m_slots[i];
+			if (!slot.block)
+				return nullptr;
+			if (slot.key == key)
+				return slot.block;
+		}
+	}
+
+	// Adds or replaces the block at p, block must not be null
+	void set(v3s16 p, MapBlock *block);
+
+	// Returns whether a block was removed
+	bool remove(v3s16 p);
+
+	void clear();
+
+	size_t size() const { return m_count; }
+	bool empty() const { return m_count == 0; }
+
+private:
+	struct Slot {
+		u64 key;
+		MapBlock *block; // nullptr means the slot is empty
+	};
+
+	static inline u64 packKey(v3s16 p)
+	{
+		return (u64)(u16)p.X | ((u64)(u16)p.Y << 16) | ((u64)(u16)p.Z << 32);
+	}
+
+	inline size_t slotFor(u64 key) const
+	{
+		// Fibonacci hashing, takes the upper bits of the product
+		return (size_t)((key * 0x9E3779B97F4A7C15ULL) >> m_shift);
+	}
+
+	void rehash(size_t capacity);
+
+	std::vector<Slot> m_slots;
+	size_t m_mask = 0;
+	u8 m_shift = 64;
+	size_t m_count = 0;
+};
@@ -23,7 +23,6 @@
 #include "serialization.h"
 #include "util/serialize.h"
 #include "util/numeric.h"
-#include "util/directiontables.h"
 #include "filesys.h"
 #include "log.h"
 #include "mapgen_carpathian.h"
@@ -429,13 +428,12 @@ void Mapgen::setLighting(u8 light, v3s16 nmin, v3s16 nmax)
 }
 
 
-void Mapgen::lightSpread(VoxelArea &a, std::queue<std::pair<v3s16, u8>> &queue,
-	const v3s16 &p, u8 light)
+void Mapgen::lightSpread(std::queue<std::pair<v3s16, u8>> &queue,
+	const v3s16 &p, u32 vi, u8 light)
 {
-	if (light <= 1 || !a.contains(p))
+	if (light <= 1)
 		return;
 
-	u32 vi = vm->m_area.index(p);
 	MapNode &n = vm->m_data[vi];
 
 	// Decay light in each of the banks separately
@@ -481,15 +479,22 @@ void Mapgen::propagateSunlight(v3s16 nmin, v3s16 nmax, bool propagate_shadow)
 	//TimeTaker t("propagateSunlight");
 	VoxelArea a(nmin, nmax);
 	bool block_is_underground = (water_level >= nmax.Y);
-	const v3s32 &em = vm->m_area.getExtent();
+	const v3s32 &ext = a.getExtent();
 
 	// NOTE: Direct access to the low 4 bits of param1 is okay here because,
 	// by definition, sunlight will never be in the night lightbank.
 
+	// Columns that still carry sunlight. The area is walked layer by layer
+	// (along the X rows of the VoxelManip) rather than column by column,
+	// and stops as soon as every column is in shadow.
+	std::vector<u8> lit(ext.X * ext.Z, 0);
+	u32 num_lit = 0;
+
+	u32 li = 0;
 	for (int z = a.MinEdge.Z; z <= a.MaxEdge.Z; z++) {
-		for (int x = a.MinEdge.X; x <= a.MaxEdge.X; x++) {
-			// see if we can get a light value from the overtop
-			u32 i = vm->m_area.index(x, a.MaxEdge.Y + 1, z);
+		// see if we can get a light value from the overtop
+		u32 i = vm->m_area.index(a.MinEdge.X, a.MaxEdge.Y + 1, z);
+		for (int x = a.MinEdge.X; x <= a.MaxEdge.X; x++, i++, li++) {
 			if (vm->m_data[i].getContent() == CONTENT_IGNORE) {
 				if (block_is_underground)
 					continue;
@@ -497,14 +502,25 @@ void Mapgen::propagateSunlight(v3s16 nmin, v3s16 nmax, bool propagate_shadow)
 					propagate_shadow) {
 				continue;
 			}
-			VoxelArea::add_y(em, i, -1);
+			lit[li] = 1;
+			num_lit++;
+		}
+	}
 
-			for (int y = a.MaxEdge.Y; y >= a.MinEdge.Y; y--) {
+	for (int y = a.MaxEdge.Y; y >= a.MinEdge.Y && num_lit > 0; y--) {
+		li = 0;
+		for (int z = a.MinEdge.Z; z <= a.MaxEdge.Z; z++) {
+			u32 i = vm->m_area.index(a.MinEdge.X, y, z);
+			for (int x = a.MinEdge.X; x <= a.MaxEdge.X; x++, i++, li++) {
+				if (!lit[li])
+					continue;
 				MapNode &n = vm->m_data[i];
-				if (!ndef->getLightingFlags(n).sunlight_propagates)
-					break;
+				if (!ndef->getLightingFlags(n).sunlight_propagates) {
+					lit[li] = 0;
+					num_lit--;
+					continue;
+				}
 				n.param1 = LIGHT_SUN;
-				VoxelArea::add_y(em, i, -1);
 			}
 		}
 	}
@@ -517,6 +533,28 @@ void Mapgen::spreadLight(const v3s16 &nmin, const v3s16 &nmax)
 	//TimeTaker t("spreadLight");
 	std::queue<std::pair<v3s16, u8>> queue;
 	VoxelArea a(nmin, nmax);
+	const v3s32 &em = vm->m_area.getExtent();
+	const s32 ystride = em.X;
+	const s32 zstride = em.X * em.Y;
+
+	// Spread the light of the node at p (index i) to the neighbors inside
+	// the area. Only the coordinate that changes has to be range checked
+	// and the neighbor index is an offset, so neither contains() nor
+	// index() is needed per neighbor.
+	auto spread_from = [&] (const v3s16 &p, u32 i, u8 light) {
+		if (p.Z < a.MaxEdge.Z)
+			lightSpread(queue, p + v3s16(0, 0, 1), i + zstride, light);
+		if (p.Y < a.MaxEdge.Y)
+			lightSpread(queue, p + v3s16(0, 1, 0), i + ystride, light);
+		if (p.X < a.MaxEdge.X)
+			lightSpread(queue, p + v3s16(1, 0, 0), i + 1, light);
+		if (p.Z > a.MinEdge.Z)
+			lightSpread(queue, p + v3s16(0, 0, -1), i - zstride, light);
+		if (p.Y > a.MinEdge.Y)
+			lightSpread(queue, p + v3s16(0, -1, 0), i - ystride, light);
+		if (p.X > a.MinEdge.X)
+			lightSpread(queue, p + v3s16(-1, 0, 0), i - 1, light);
+	};
 
 	for (int z = a.MinEdge.Z; z <= a.MaxEdge.Z; z++) {
 		for (int y = a.MinEdge.Y; y <= a.MaxEdge.Y; y++) {
@@ -539,10 +577,8 @@ void Mapgen::spreadLight(const v3s16 &nmin, const v3s16 &nmax)
 
 				u8 light = n.param1;
 				if (light) {
-					const v3s16 p(x, y, z);
 					// spread to all 6 neighbor nodes
-					for (const auto &dir : g_6dirs)
-						lightSpread(a, queue, p + dir, light);
+					spread_from(v3s16(x, y, z), i, light);
 				}
 			}
 		}
@@ -551,8 +587,7 @@ void Mapgen::spreadLight(const v3s16 &nmin, const v3s16 &nmax)
 	while (!queue.empty()) {
 		const auto &i = queue.front();
 		// spread to all 6 neighbor nodes
-		for (const auto &dir : g_6dirs)
-			lightSpread(a, queue, i.first + dir, i.second);
+		spread_from(i.first, vm->m_area.index(i.first), i.second);
 		queue.pop();
 	}
 
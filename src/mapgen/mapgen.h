@@ -249,14 +249,14 @@ class Mapgen {
 	/**
 	 * Spread light to the node at the given position, add to queue if changed.
 	 * The given light value is diminished once.
-	 * @param a VoxelArea being operated on
 	 * @param queue Queue for later lightSpread() calls
-	 * @param p Node position
+	 * @param p Node position, inside the area being operated on
+	 * @param vi Index of the node in the VoxelManip
 	 * @param light Light value (contains both banks)
 	 *
 	 */
-	void lightSpread(VoxelArea &a, std::queue<std::pair<v3s16, u8>> &queue,
-		const v3s16 &p, u8 light);
+	void lightSpread(std::queue<std::pair<v3s16, u8>> &queue,
+		const v3s16 &p, u32 vi, u8 light);
 
 	// isLiquidHorizontallyFlowable() is a helper function for updateLiquid()
 	// that checks whether there are floodable nodes without liquid beneath
@@ -39,12 +39,21 @@ DecorationManager::DecorationManager(IGameDef *gamedef) :
 void DecorationManager::placeAllDecos(Mapgen *mg, u32 blockseed,
 	v3s16 nmin, v3s16 nmax)
 {
+	DecoSurfaceIndex surfaces;
+	surfaces.build(mg, nmin, nmax);
+
 	for (size_t i = 0; i != m_objects.size(); i++) {
 		Decoration *deco = (Decoration *)m_objects[i];
 		if (!deco)
 			continue;
 
-		deco->placeDeco(mg, blockseed, nmin, nmax);
+		// Every decoration has its own random sequence seeded from blockseed,
+		// so skipping one that cannot place anything does not affect the others
+		if (surfaces.canMatch(deco)) {
+			size_t nplaced = deco->placeDeco(mg, blockseed, nmin, nmax);
+			if (nplaced > 0 && deco->mayAlterSurface())
+				surfaces.invalidate();
+		}
 		blockseed++;
 	}
 }
@@ -60,10 +69,108 @@ DecorationManager *DecorationManager::clone() const
 ///////////////////////////////////////////////////////////////////////////////
 
 
+void DecoSurfaceIndex::build(Mapgen *mg, v3s16 nmin, v3s16 nmax)
+{
+	m_mg = mg;
+	m_nmin = nmin;
+	m_nmax = nmax;
+	m_dirty = true;
+
+	m_biomes_present.clear();
+	if (!mg->biomemap)
+		return;
+
+	size_t ncolumns = (nmax.X - nmin.X + 1) * (nmax.Z - nmin.Z + 1);
+	for (size_t i = 0; i != ncolumns; i++) {
+		biome_t biome = mg->biomemap[i];
+		if (biome >= m_biomes_present.size())
+			m_biomes_present.resize(biome + 1, false);
+		m_biomes_present[biome] = true;
+	}
+}
+
+
+void DecoSurfaceIndex::buildSurfaces()
+{
+	m_dirty = false;
+	m_surfaces.clear();
+
+	// The biomemap does not change during decoration placement, the
+	// surface nodes may
+	MMVManip *vm = m_mg->vm;
+	size_t index = 0;
+	for (s16 z = m_nmin.Z; z <= m_nmax.Z; z++)
+	for (s16 x = m_nmin.X; x <= m_nmax.X; x++, index++) {
+		s16 y = m_mg->heightmap[index];
+		if (y < m_nmin.Y || y > m_nmax.Y)
+			continue;
+
+		u32 vi = vm->m_area.index(x, y, z);
+		u32 key = (u32)vm->m_data[vi].getContent() << 16;
+		if (m_mg->biomemap)
+			key |= m_mg->biomemap[index];
+		m_surfaces.push_back(key);
+	}
+
+	SORT_AND_UNIQUE(m_surfaces);
+}
+
+
+bool DecoSurfaceIndex::canMatch(const Decoration *deco)
+{
+	bool check_biomes = m_mg->biomemap && !deco->biomes.empty();
+
+	if (check_biomes) {
+		bool biome_present = false;
+		for (biome_t biome : deco->biomes) {
+			if (biome < m_biomes_present.size() && m_biomes_present[biome]) {
+				biome_present = true;
+				break;
+			}
+		}
+		if (!biome_present)
+			return false;
+	}
+
+	// Decorations placed on anything other than the heightmap surface
+	// search their own surfaces per column
+	if (!deco->usesHeightmap() || !m_mg->heightmap)
+		return true;
+
+	if (m_dirty)
+		buildSurfaces();
+
+	for (u32 key : m_surfaces) {
+		if (!deco->isPlaceOn(key >> 16))
+			continue;
+		if (!check_biomes || deco->biomes.count(key & 0xFFFF))
+			return true;
+	}
+	return false;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+
+
+static void build_content_map(std::vector<bool> &map,
+	const std::vector<content_t> &ids)
+{
+	map.clear();
+	for (content_t c : ids) {
+		if (c >= map.size())
+			map.resize(c + 1, false);
+		map[c] = true;
+	}
+}
+
+
 void Decoration::resolveNodeNames()
 {
 	getIdsFromNrBacklog(&c_place_on);
 	getIdsFromNrBacklog(&c_spawnby);
+	build_content_map(m_place_on_map, c_place_on);
+	build_content_map(m_spawnby_map, c_spawnby);
 }
 
 
@@ -74,7 +181,7 @@ bool Decoration::canPlaceDecoration(MMVManip *vm, v3s16 p)
 
 	// Check if the decoration can be placed on this node
 	u32 vi = vm->m_area.index(p);
-	if (!CONTAINS(c_place_on, vm->m_data[vi].getContent()))
+	if (!isPlaceOn(vm->m_data[vi].getContent()))
 		return false;
 
 	// Don't continue if there are no spawnby constraints
@@ -100,7 +207,7 @@ bool Decoration::canPlaceDecoration(MMVManip *vm, v3s16 p)
 		if (!vm->m_area.contains(index))
 			continue;
 
-		if (CONTAINS(c_spawnby, vm->m_data[index].getContent()))
+		if (isSpawnBy(vm->m_data[index].getContent()))
 			nneighs++;
 	}
 
@@ -112,7 +219,7 @@ bool Decoration::canPlaceDecoration(MMVManip *vm, v3s16 p)
 			if (!vm->m_area.contains(index))
 				continue;
 
-			if (CONTAINS(c_spawnby, vm->m_data[index].getContent()))
+			if (isSpawnBy(vm->m_data[index].getContent()))
 				nneighs++;
 		}
 
@@ -124,11 +231,13 @@ bool Decoration::canPlaceDecoration(MMVManip *vm, v3s16 p)
 }
 
 
-void Decoration::placeDeco(Mapgen *mg, u32 blockseed, v3s16 nmin, v3s16 nmax)
+size_t Decoration::placeDeco(Mapgen *mg, u32 blockseed, v3s16 nmin, v3s16 nmax)
 {
 	// Skip if y ranges do not overlap
 	if (nmax.Y < y_min || y_max < nmin.Y)
-		return;
+		return 0;
+
+	size_t nplaced = 0;
 
 	PcgRandom ps(blockseed + 53);
 	int carea_size = nmax.X - nmin.X + 1;
@@ -210,8 +319,10 @@ void Decoration::placeDeco(Mapgen *mg, u32 blockseed, v3s16 nmin, v3s16 nmax)
 							continue;
 
 						v3s16 pos(x, y, z);
-						if (generate(mg->vm, &ps, pos, false))
+						if (generate(mg->vm, &ps, pos, false)) {
 							mg->gennotify.addDecorationEvent(pos, index);
+							nplaced++;
+						}
 					}
 				}
 
@@ -222,8 +333,10 @@ void Decoration::placeDeco(Mapgen *mg, u32 blockseed, v3s16 nmin, v3s16 nmax)
 							continue;
 
 						v3s16 pos(x, y, z);
-						if (generate(mg->vm, &ps, pos, true))
+						if (generate(mg->vm, &ps, pos, true)) {
 							mg->gennotify.addDecorationEvent(pos, index);
+							nplaced++;
+						}
 					}
 				}
 			} else { // Heightmap decorations
@@ -245,13 +358,15 @@ void Decoration::placeDeco(Mapgen *mg, u32 blockseed, v3s16 nmin, v3s16 nmax)
 				}
 
 				v3s16 pos(x, y, z);
-				if (generate(mg->vm, &ps, pos, false))
+				if (generate(mg->vm, &ps, pos, false)) {
 					mg->gennotify.addDecorationEvent(pos, index);
+					nplaced++;
+				}
 			}
 		}
 	}
 
-	return;
+	return nplaced;
 }
 
 
@@ -271,6 +386,8 @@ void Decoration::cloneTo(Decoration *def) const
 	def->nspawnby = nspawnby;
 	def->place_offset_y = place_offset_y;
 	def->biomes = biomes;
+	def->m_place_on_map = m_place_on_map;
+	def->m_spawnby_map = m_spawnby_map;
 }
 
 
@@ -299,6 +416,13 @@ void DecoSimple::resolveNodeNames()
 }
 
 
+bool DecoSimple::mayAlterSurface() const
+{
+	// Heightmap decorations starting above the surface only write above it
+	return !usesHeightmap() || place_offset_y < 0;
+}
+
+
 size_t DecoSimple::generate(MMVManip *vm, PcgRandom *pr, v3s16 p, bool ceiling)
 {
 	// Don't bother if there aren't any decorations to place
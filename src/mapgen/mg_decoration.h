@@ -35,6 +35,36 @@ enum DecorationType {
 
 extern const FlagDesc flagdesc_deco[];
 
+class Decoration;
+
+/*
+	Per-chunk summary of the heightmap surface, grouped by surface content
+	and biome. Used to skip decorations that cannot be placed anywhere in
+	the chunk before they draw any random numbers.
+*/
+class DecoSurfaceIndex {
+public:
+	void build(Mapgen *mg, v3s16 nmin, v3s16 nmax);
+
+	// Returns false only if the decoration can certainly not be placed
+	// anywhere in the chunk
+	bool canMatch(const Decoration *deco);
+
+	// Call after surface nodes may have been replaced
+	void invalidate() { m_dirty = true; }
+
+private:
+	void buildSurfaces();
+
+	Mapgen *m_mg = nullptr;
+	v3s16 m_nmin, m_nmax;
+	bool m_dirty = true;
+	// sorted unique (surface content << 16 | biome) pairs
+	std::vector<u32> m_surfaces;
+	// vector index = biome_t, biomes occurring in the chunk
+	std::vector<bool> m_biomes_present;
+};
+
 
 class Decoration : public ObjDef, public NodeResolver {
 public:
@@ -44,10 +74,27 @@ class Decoration : public ObjDef, public NodeResolver {
 	virtual void resolveNodeNames();
 
 	bool canPlaceDecoration(MMVManip *vm, v3s16 p);
-	void placeDeco(Mapgen *mg, u32 blockseed, v3s16 nmin, v3s16 nmax);
+	size_t placeDeco(Mapgen *mg, u32 blockseed, v3s16 nmin, v3s16 nmax);
 
 	virtual size_t generate(MMVManip *vm, PcgRandom *pr, v3s16 p, bool ceiling) = 0;
 
+	// Whether the decoration is placed on the heightmap surface
+	bool usesHeightmap() const
+	{
+		return !(flags & (DECO_ALL_FLOORS | DECO_ALL_CEILINGS | DECO_LIQUID_SURFACE));
+	}
+	// Whether placing the decoration can replace heightmap surface nodes
+	virtual bool mayAlterSurface() const { return true; }
+
+	inline bool isPlaceOn(content_t c) const
+	{
+		return c < m_place_on_map.size() && m_place_on_map[c];
+	}
+	inline bool isSpawnBy(content_t c) const
+	{
+		return c < m_spawnby_map.size() && m_spawnby_map[c];
+	}
+
 	u32 flags = 0;
 	int mapseed = 0;
 	std::vector<content_t> c_place_on;
@@ -65,6 +112,10 @@ class Decoration : public ObjDef, public NodeResolver {
 
 protected:
 	void cloneTo(Decoration *def) const;
+
+	// vector index = content_t, built from c_place_on and c_spawnby
+	std::vector<bool> m_place_on_map;
+	std::vector<bool> m_spawnby_map;
 };
 
 
@@ -74,6 +125,7 @@ class DecoSimple : public Decoration {
 
 	virtual void resolveNodeNames();
 	virtual size_t generate(MMVManip *vm, PcgRandom *pr, v3s16 p, bool ceiling);
+	virtual bool mayAlterSurface() const;
 
 	std::vector<content_t> c_decos;
 	s16 deco_height;
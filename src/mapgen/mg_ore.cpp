@@ -78,6 +78,34 @@ void Ore::resolveNodeNames()
 {
 	getIdFromNrBacklog(&c_ore, "", CONTENT_AIR);
 	getIdsFromNrBacklog(&c_wherein);
+	updateWhereinMap();
+}
+
+
+void Ore::updateWhereinMap()
+{
+	m_wherein_map.clear();
+	for (content_t c : c_wherein) {
+		if (c >= m_wherein_map.size())
+			m_wherein_map.resize(c + 1, false);
+		m_wherein_map[c] = true;
+	}
+}
+
+
+bool Ore::getBiomeColumns(std::vector<bool> &column_ok, const biome_t *biomemap,
+	size_t ncolumns) const
+{
+	column_ok.assign(ncolumns, true);
+	if (!biomemap || biomes.empty())
+		return true;
+
+	bool any_ok = false;
+	for (size_t i = 0; i != ncolumns; i++) {
+		column_ok[i] = biomes.count(biomemap[i]) != 0;
+		any_ok |= column_ok[i];
+	}
+	return any_ok;
 }
 
 
@@ -105,6 +133,7 @@ void Ore::cloneTo(Ore *def) const
 	NodeResolver::cloneTo(def);
 	def->c_ore = c_ore;
 	def->c_wherein = c_wherein;
+	def->m_wherein_map = m_wherein_map;
 	def->clust_scarcity = clust_scarcity;
 	def->clust_num_ores = clust_num_ores;
 	def->clust_size = clust_size;
@@ -167,7 +196,7 @@ void OreScatter::generate(MMVManip *vm, int mapseed, u32 blockseed,
 				continue;
 
 			u32 i = vm->m_area.index(x0 + x1, y0 + y1, z0 + z1);
-			if (!CONTAINS(c_wherein, vm->m_data[i].getContent()))
+			if (!isWherein(vm->m_data[i].getContent()))
 				continue;
 
 			vm->m_data[i] = n_ore;
@@ -236,7 +265,7 @@ void OreSheet::generate(MMVManip *vm, int mapseed, u32 blockseed,
 			u32 i = vm->m_area.index(x, y, z);
 			if (!vm->m_area.contains(i))
 				continue;
-			if (!CONTAINS(c_wherein, vm->m_data[i].getContent()))
+			if (!isWherein(vm->m_data[i].getContent()))
 				continue;
 
 			vm->m_data[i] = n_ore;
@@ -330,7 +359,7 @@ void OrePuff::generate(MMVManip *vm, int mapseed, u32 blockseed,
 			u32 i = vm->m_area.index(x, y, z);
 			if (!vm->m_area.contains(i))
 				continue;
-			if (!CONTAINS(c_wherein, vm->m_data[i].getContent()))
+			if (!isWherein(vm->m_data[i].getContent()))
 				continue;
 
 			vm->m_data[i] = n_ore;
@@ -386,7 +415,7 @@ void OreBlob::generate(MMVManip *vm, int mapseed, u32 blockseed,
 		for (u32 y1 = 0; y1 != csize; y1++)
 		for (u32 x1 = 0; x1 != csize; x1++, index++) {
 			u32 i = vm->m_area.index(x0 + x1, y0 + y1, z0 + z1);
-			if (!CONTAINS(c_wherein, vm->m_data[i].getContent()))
+			if (!isWherein(vm->m_data[i].getContent()))
 				continue;
 
 			// Lazily generate noise only if there's a chance of ore being placed
@@ -457,43 +486,46 @@ void OreVein::generate(MMVManip *vm, int mapseed, u32 blockseed,
 		sizey_prev = sizey;
 	}
 
+	// Resolve the biome of each column once instead of per node
+	std::vector<bool> column_ok;
+	if (!getBiomeColumns(column_ok, biomemap, sizex * (nmax.Z - nmin.Z + 1)))
+		return;
+
 	bool noise_generated = false;
 	size_t index = 0;
 	for (int z = nmin.Z; z <= nmax.Z; z++)
-	for (int y = nmin.Y; y <= nmax.Y; y++)
-	for (int x = nmin.X; x <= nmax.X; x++, index++) {
-		u32 i = vm->m_area.index(x, y, z);
-		if (!vm->m_area.contains(i))
-			continue;
-		if (!CONTAINS(c_wherein, vm->m_data[i].getContent()))
-			continue;
-
-		if (biomemap && !biomes.empty()) {
-			u32 bmapidx = sizex * (z - nmin.Z) + (x - nmin.X);
-			auto it = biomes.find(biomemap[bmapidx]);
-			if (it == biomes.end())
+	for (int y = nmin.Y; y <= nmax.Y; y++) {
+		// Walk the row linearly through the VoxelManip
+		u32 i = vm->m_area.index(nmin.X, y, z);
+		u32 bmapidx = sizex * (z - nmin.Z);
+		for (int x = nmin.X; x <= nmax.X; x++, index++, i++, bmapidx++) {
+			if (!vm->m_area.contains(i))
+				continue;
+			if (!isWherein(vm->m_data[i].getContent()))
+				continue;
+			if (!column_ok[bmapidx])
 				continue;
-		}
 
-		// Same lazy generation optimization as in OreBlob
-		if (!noise_generated) {
-			noise_generated = true;
-			noise->noiseMap3D(nmin.X, nmin.Y, nmin.Z);
-			noise2->noiseMap3D(nmin.X, nmin.Y, nmin.Z);
-		}
+			// Same lazy generation optimization as in OreBlob
+			if (!noise_generated) {
+				noise_generated = true;
+				noise->noiseMap3D(nmin.X, nmin.Y, nmin.Z);
+				noise2->noiseMap3D(nmin.X, nmin.Y, nmin.Z);
+			}
 
-		// randval ranges from -1..1
-		/*
-			Note: can generate values slightly larger than 1
-			but this can't be changed as mapgen must be deterministic accross versions.
-		*/
-		float randval   = (float)pr.next() / float(pr.RANDOM_RANGE / 2) - 1.f;
-		float noiseval  = contour(noise->result[index]);
-		float noiseval2 = contour(noise2->result[index]);
-		if (noiseval * noiseval2 + randval * random_factor < nthresh)
-			continue;
+			// randval ranges from -1..1
+			/*
+				Note: can generate values slightly larger than 1
+				but this can't be changed as mapgen must be deterministic accross versions.
+			*/
+			float randval   = (float)pr.next() / float(pr.RANDOM_RANGE / 2) - 1.f;
+			float noiseval  = contour(noise->result[index]);
+			float noiseval2 = contour(noise2->result[index]);
+			if (noiseval * noiseval2 + randval * random_factor < nthresh)
+				continue;
 
-		vm->m_data[i] = n_ore;
+			vm->m_data[i] = n_ore;
+		}
 	}
 }
 
@@ -576,7 +608,7 @@ void OreStratum::generate(MMVManip *vm, int mapseed, u32 blockseed,
 			u32 i = vm->m_area.index(x, y, z);
 			if (!vm->m_area.contains(i))
 				continue;
-			if (!CONTAINS(c_wherein, vm->m_data[i].getContent()))
+			if (!isWherein(vm->m_data[i].getContent()))
 				continue;
 
 			vm->m_data[i] = n_ore;
@@ -62,8 +62,26 @@ class Ore : public ObjDef, public NodeResolver {
 	virtual void generate(MMVManip *vm, int mapseed, u32 blockseed,
 		v3s16 nmin, v3s16 nmax, biome_t *biomemap) = 0;
 
+	// Whether the ore may replace a node of content c
+	inline bool isWherein(content_t c) const
+	{
+		return c < m_wherein_map.size() && m_wherein_map[c];
+	}
+
 protected:
 	void cloneTo(Ore *def) const;
+
+	// Rebuilds m_wherein_map from c_wherein
+	void updateWhereinMap();
+
+	// Fills column_ok (indexed like the biomemap) with whether the biome of
+	// each column of the area is allowed for this ore.
+	// Returns false if no column is allowed.
+	bool getBiomeColumns(std::vector<bool> &column_ok, const biome_t *biomemap,
+		size_t ncolumns) const;
+
+	// vector index = content_t, built once from c_wherein
+	std::vector<bool> m_wherein_map;
 };
 
 class OreScatter : public Ore {
@@ -105,13 +105,26 @@ void Schematic::resolveNodeNames()
 		// Unfold condensed ID layout to content_t
 		schemdata[i].setContent(c_nodes[c_original]);
 	}
+
+	invalidateCompiled();
 }
 
 
-void Schematic::blitToVManip(MMVManip *vm, v3s16 p, Rotation rot, bool force_place)
+void Schematic::invalidateCompiled()
 {
-	assert(schemdata && slice_probs);
-	sanity_check(m_ndef != NULL);
+	for (auto &compiled : m_compiled)
+		compiled.reset();
+}
+
+
+const CompiledSchematic &Schematic::getCompiled(Rotation rot)
+{
+	if (rot > ROTATE_270)
+		rot = ROTATE_0;
+	if (m_compiled[rot])
+		return *m_compiled[rot];
+
+	auto comp = std::make_unique<CompiledSchematic>();
 
 	int xstride = 1;
 	int ystride = size.X;
@@ -146,29 +159,96 @@ void Schematic::blitToVManip(MMVManip *vm, v3s16 p, Rotation rot, bool force_pla
 			i_step_z = zstride;
 	}
 
-	s16 y_map = p.Y;
+	comp->layer_start.reserve(sy + 1);
 	for (s16 y = 0; y != sy; y++) {
-		if ((slice_probs[y] != MTSCHEM_PROB_ALWAYS) &&
-			(slice_probs[y] <= myrand_range(1, MTSCHEM_PROB_ALWAYS)))
-			continue;
+		comp->layer_start.push_back(comp->runs.size());
 
 		for (s16 z = 0; z != sz; z++) {
 			u32 i = z * i_step_z + y * ystride + i_start;
+			bool in_run = false;
 			for (s16 x = 0; x != sx; x++, i += i_step_x) {
-				v3s16 pos(p.X + x, y_map, p.Z + z);
-				if (!vm->m_area.contains(pos))
+				const MapNode &n = schemdata[i];
+				u8 placement_prob = n.param1 & MTSCHEM_PROB_MASK;
+				if (n.getContent() == CONTENT_IGNORE ||
+						placement_prob == MTSCHEM_PROB_NEVER) {
+					in_run = false;
 					continue;
+				}
 
-				if (schemdata[i].getContent() == CONTENT_IGNORE)
-					continue;
+				if (!in_run) {
+					comp->runs.push_back({v2s16(x, z), 0, true, true,
+						(u32)comp->nodes.size()});
+					in_run = true;
+				}
 
-				u8 placement_prob     = schemdata[i].param1 & MTSCHEM_PROB_MASK;
-				bool force_place_node = schemdata[i].param1 & MTSCHEM_FORCE_PLACE;
+				CompiledSchematic::Run &run = comp->runs.back();
+				run.length++;
+				run.all_always &= placement_prob == MTSCHEM_PROB_ALWAYS;
+				run.all_forced &= (n.param1 & MTSCHEM_FORCE_PLACE) != 0;
+
+				MapNode placed = n;
+				placed.param1 = 0;
+				if (rot)
+					placed.rotateAlongYAxis(m_ndef, rot);
+				comp->nodes.push_back(placed);
+				comp->probs.push_back(n.param1);
+			}
+		}
+	}
+	comp->layer_start.push_back(comp->runs.size());
+
+	m_compiled[rot] = std::move(comp);
+	return *m_compiled[rot];
+}
 
-				if (placement_prob == MTSCHEM_PROB_NEVER)
-					continue;
 
-				u32 vi = vm->m_area.index(pos);
+void Schematic::blitToVManip(MMVManip *vm, v3s16 p, Rotation rot, bool force_place)
+{
+	assert(schemdata && slice_probs);
+	sanity_check(m_ndef != NULL);
+
+	const CompiledSchematic &comp = getCompiled(rot);
+	const VoxelArea &area = vm->m_area;
+
+	s16 y_map = p.Y;
+	for (s16 y = 0; y != size.Y; y++) {
+		if ((slice_probs[y] != MTSCHEM_PROB_ALWAYS) &&
+			(slice_probs[y] <= myrand_range(1, MTSCHEM_PROB_ALWAYS)))
+			continue;
+
+		if (y_map < area.MinEdge.Y || y_map > area.MaxEdge.Y) {
+			y_map++;
+			continue;
+		}
+
+		for (u32 r = comp.layer_start[y]; r != comp.layer_start[y + 1]; r++) {
+			const CompiledSchematic::Run &run = comp.runs[r];
+
+			s32 z_map = p.Z + run.pos.Y;
+			if (z_map < area.MinEdge.Z || z_map > area.MaxEdge.Z)
+				continue;
+
+			// Clip the run to the VoxelManip
+			s32 x_start = p.X + run.pos.X;
+			s32 x0 = MYMAX(x_start, area.MinEdge.X);
+			s32 x1 = MYMIN(x_start + run.length - 1, area.MaxEdge.X);
+			if (x0 > x1)
+				continue;
+
+			u32 i = run.first + (x0 - x_start);
+			u32 vi = area.index(x0, y_map, z_map);
+			u32 count = x1 - x0 + 1;
+
+			// Nothing to check per node, copy the whole run
+			if (run.all_always && (force_place || run.all_forced)) {
+				std::copy_n(&comp.nodes[i], count, &vm->m_data[vi]);
+				continue;
+			}
+
+			for (; count != 0; count--, i++, vi++) {
+				u8 placement_prob     = comp.probs[i] & MTSCHEM_PROB_MASK;
+				bool force_place_node = comp.probs[i] & MTSCHEM_FORCE_PLACE;
+
 				if (!force_place && !force_place_node) {
 					content_t c = vm->m_data[vi].getContent();
 					if (c != CONTENT_AIR && c != CONTENT_IGNORE)
@@ -179,11 +259,7 @@ void Schematic::blitToVManip(MMVManip *vm, v3s16 p, Rotation rot, bool force_pla
 					(placement_prob <= myrand_range(1, MTSCHEM_PROB_ALWAYS)))
 					continue;
 
-				vm->m_data[vi] = schemdata[i];
-				vm->m_data[vi].param1 = 0;
-
-				if (rot)
-					vm->m_data[vi].rotateAlongYAxis(m_ndef, rot);
+				vm->m_data[vi] = comp.nodes[i];
 			}
 		}
 		y_map++;
@@ -322,6 +398,7 @@ bool Schematic::deserializeFromMts(std::istream *is)
 
 	delete []schemdata;
 	schemdata = new MapNode[nodecount];
+	invalidateCompiled();
 
 	std::stringstream d_ss(std::ios_base::binary | std::ios_base::in | std::ios_base::out);
 	decompress(ss, d_ss, MTSCHEM_MAPNODE_SER_FMT_VER);
@@ -544,6 +621,7 @@ bool Schematic::getSchematicFromMap(Map *map, v3s16 p1, v3s16 p2)
 		slice_probs[y] = MTSCHEM_PROB_ALWAYS;
 
 	schemdata = new MapNode[size.X * size.Y * size.Z];
+	invalidateCompiled();
 
 	u32 i = 0;
 	for (s16 z = p1.Z; z <= p2.Z; z++)
@@ -586,6 +664,8 @@ void Schematic::applyProbabilities(v3s16 p0,
 		if (slice < size.Y)
 			slice_probs[slice] = (*splist)[i].second;
 	}
+
+	invalidateCompiled();
 }
 
 
@@ -614,4 +694,6 @@ void Schematic::condenseContentIds()
 		}
 		schemdata[i].setContent(id);
 	}
+
+	invalidateCompiled();
 }
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include "mg_decoration.h"
 #include "util/string.h"
 
@@ -76,6 +77,30 @@ enum SchematicFormatType {
 	SCHEM_FMT_LUA,
 };
 
+/*
+	Schematic node data prepared for placement with one rotation.
+	Nodes that are never placed are left out. The remaining ones are stored
+	as runs along the X axis with the rotation already applied to param2 and
+	the placement probabilities split out into a separate array.
+*/
+struct CompiledSchematic {
+	struct Run {
+		v2s16 pos;       // X/Z offset of the first node from the placement position
+		u16 length;
+		bool all_always; // all nodes have MTSCHEM_PROB_ALWAYS
+		bool all_forced; // all nodes have MTSCHEM_FORCE_PLACE
+		u32 first;       // index of the first node in 'nodes' and 'probs'
+	};
+
+	// Runs of Y slice y are [layer_start[y], layer_start[y + 1])
+	std::vector<u32> layer_start;
+	std::vector<Run> runs;
+	// Nodes as placed, param1 cleared
+	std::vector<MapNode> nodes;
+	// Original param1: placement probability and force placement bit
+	std::vector<u8> probs;
+};
+
 class Schematic : public ObjDef, public NodeResolver {
 public:
 	Schematic() = default;
@@ -109,9 +134,17 @@ class Schematic : public ObjDef, public NodeResolver {
 	MapNode *schemdata = nullptr;
 	u8 *slice_probs = nullptr;
 
+	// Drops the compiled data, must be called after modifying schemdata
+	void invalidateCompiled();
+
 private:
 	// Counterpart to the node resolver: Condense content_t to a sequential "m_nodenames" list
 	void condenseContentIds();
+
+	// Built on first placement with the respective rotation
+	const CompiledSchematic &getCompiled(Rotation rot);
+
+	std::unique_ptr<CompiledSchematic> m_compiled[ROTATE_RAND];
 };
 
 class SchematicManager : public ObjDefManager {
@@ -5,6 +5,7 @@
 #include "mapsector.h"
 #include "exceptions.h"
 #include "mapblock.h"
+#include "map.h"
 #include "serialization.h"
 
 MapSector::MapSector(Map *parent, v2s16 pos, IGameDef *gamedef):
@@ -25,6 +26,8 @@ void MapSector::deleteBlocks()
 	m_block_cache = nullptr;
 
 	// Delete all blocks
+	for (auto &it : m_blocks)
+		m_parent->m_block_index.remove(it.second->getPos());
 	m_blocks.clear();
 }
 
@@ -70,6 +73,7 @@ MapBlock *MapSector::createBlankBlock(s16 y)
 	MapBlock *block = block_u.get();
 
 	m_blocks[y] = std::move(block_u);
+	m_parent->m_block_index.set(block->getPos(), block);
 
 	return block;
 }
@@ -87,6 +91,7 @@ void MapSector::insertBlock(std::unique_ptr<MapBlock> block)
 	assert(p2d == m_pos);
 
 	// Insert into container
+	m_parent->m_block_index.set(block->getPos(), block.get());
 	m_blocks[block_y] = std::move(block);
 }
 
@@ -109,6 +114,7 @@ std::unique_ptr<MapBlock> MapSector::detachBlock(MapBlock *block)
 	std::unique_ptr<MapBlock> ret = std::move(it->second);
 	assert(ret.get() == block);
 	m_blocks.erase(it);
+	m_parent->m_block_index.remove(block->getPos());
 
 	// Mark as removed
 	block->makeOrphan();
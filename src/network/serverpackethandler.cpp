@@ -1781,7 +1781,7 @@ void Server::handleCommand_ModChannelMsg(NetworkPacket *pkt)
     }
 
     // Rate limiting: max 5 messages per second per peer
-    float current_time = getTimeMs() / 1000.0f;
+    float current_time = porting::getTimeMs() / 1000.0f;
     float min_interval = 0.2f; // 200ms between messages (5 per second)
     
     auto rate_it = m_modchannel_rate_limiter.find(peer_id);
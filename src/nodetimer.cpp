@@ -7,6 +7,7 @@
 #include "serialization.h"
 #include "util/serialize.h"
 #include "constants.h" // MAP_BLOCKSIZE
+#include <algorithm>
 
 /*
 	NodeTimer
@@ -48,7 +49,7 @@ void NodeTimerList::serialize(std::ostream &os, u8 map_format_version) const
 	for (const auto &timer : m_timers) {
 		NodeTimer t = timer.second;
 		NodeTimer nt = NodeTimer(t.timeout,
-			t.timeout - (f32)(timer.first - m_time), t.position);
+			t.timeout - (f32)(timer.first - getTime()), t.position);
 		v3s16 p = t.position;
 
 		u16 p16 = p.Z * MAP_BLOCKSIZE * MAP_BLOCKSIZE + p.Y * MAP_BLOCKSIZE + p.X;
@@ -110,26 +111,82 @@ void NodeTimerList::deSerialize(std::istream &is, u8 map_format_version)
 	}
 }
 
+void NodeTimerList::attach(NodeTimerScheduler *scheduler, v3s16 blockpos)
+{
+	detach();
+	m_scheduler = scheduler;
+	m_blockpos = blockpos;
+	m_time_offset = scheduler->getTime() - m_time;
+	schedule();
+}
+
+void NodeTimerList::detach()
+{
+	m_time = getTime();
+	m_scheduler = nullptr;
+}
+
 std::vector<NodeTimer> NodeTimerList::step(float dtime)
 {
-	std::vector<NodeTimer> elapsed_timers;
+	detach();
 	m_time += dtime;
-	if (m_next_trigger_time == -1. || m_time < m_next_trigger_time) {
+	return popElapsed();
+}
+
+std::vector<NodeTimer> NodeTimerList::popElapsed()
+{
+	std::vector<NodeTimer> elapsed_timers;
+	const double time = getTime();
+	if (m_next_trigger_time == -1. || time < m_next_trigger_time) {
+		// Visited early, for a timer that was removed or restarted
+		schedule();
 		return elapsed_timers;
 	}
 	auto i = m_timers.begin();
 	// Process timers
-	for (; i != m_timers.end() && i->first <= m_time; ++i) {
+	for (; i != m_timers.end() && i->first <= time; ++i) {
 		NodeTimer t = i->second;
-		t.elapsed = t.timeout + (f32)(m_time - i->first);
+		t.elapsed = t.timeout + (f32)(time - i->first);
 		elapsed_timers.push_back(t);
 		m_iterators.erase(t.position);
 	}
 	// Delete elapsed timers
 	m_timers.erase(m_timers.begin(), i);
-	if (m_timers.empty())
+	if (m_timers.empty()) {
 		m_next_trigger_time = -1.;
-	else
+	} else {
 		m_next_trigger_time = m_timers.begin()->first;
+		schedule();
+	}
 	return elapsed_timers;
 }
+
+void NodeTimerList::schedule()
+{
+	if (!m_scheduler || m_next_trigger_time == -1.)
+		return;
+	const double time = m_next_trigger_time + m_time_offset;
+	// Entries up to the current time have been taken out of the queue
+	if (m_scheduled_time > m_scheduler->getTime() && m_scheduled_time <= time)
+		return;
+	m_scheduler->schedule(m_blockpos, time);
+	m_scheduled_time = time;
+}
+
+/*
+	NodeTimerScheduler
+*/
+
+std::vector<v3s16> NodeTimerScheduler::step(float dtime)
+{
+	m_time += dtime;
+	std::vector<v3s16> blocks;
+	while (!m_queue.empty() && m_queue.top().time <= m_time) {
+		blocks.push_back(m_queue.top().blockpos);
+		m_queue.pop();
+	}
+	// A block can be in there more than once
+	std::sort(blocks.begin(), blocks.end());
+	blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
+	return blocks;
+}
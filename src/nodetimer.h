@@ -7,6 +7,7 @@
 #include "irr_v3d.h"
 #include <iostream>
 #include <map>
+#include <queue>
 #include <vector>
 
 /*
@@ -35,6 +36,43 @@ class NodeTimer
 	v3s16 position;
 };
 
+/*
+	Common time of the timer lists of all active blocks, so that they don't
+	have to be stepped one by one. Remembers when each block has its next
+	timer due, so only those blocks are visited.
+*/
+
+class NodeTimerScheduler
+{
+public:
+	double getTime() const { return m_time; }
+
+	// A timer of the block is due at the given time
+	void schedule(v3s16 blockpos, double time) {
+		m_queue.push(Entry{time, blockpos});
+	}
+
+	// Move forward in time, returns the blocks that may have elapsed timers
+	std::vector<v3s16> step(float dtime);
+
+	size_t size() const { return m_queue.size(); }
+
+private:
+	struct Entry {
+		double time;
+		v3s16 blockpos;
+
+		bool operator>(const Entry &other) const { return time > other.time; }
+	};
+
+	// Entries of blocks that were deactivated or whose timers were removed
+	// are not deleted, they just turn up without an elapsed timer. Blocks
+	// don't queue a later entry while they have an earlier one, so there
+	// are about as many entries as blocks with timers.
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> m_queue;
+	double m_time = 0.0;
+};
+
 /*
 	List of timers of all the nodes of a block
 */
@@ -54,7 +92,7 @@ class NodeTimerList
 		if (n == m_iterators.end())
 			return NodeTimer();
 		NodeTimer t = n->second->second;
-		t.elapsed = t.timeout - (n->second->first - m_time);
+		t.elapsed = t.timeout - (n->second->first - getTime());
 		return t;
 	}
 	// Deletes timer
@@ -68,21 +106,25 @@ class NodeTimerList
 			// since we only test equality of floats as an ordered type
 			// and thus we never lose precision
 			if (removed_time == m_next_trigger_time) {
-				if (m_timers.empty())
+				if (m_timers.empty()) {
 					m_next_trigger_time = -1.;
-				else
+				} else {
 					m_next_trigger_time = m_timers.begin()->first;
+					schedule();
+				}
 			}
 		}
 	}
 	// Undefined behavior if there already is a timer
 	void insert(const NodeTimer &timer) {
 		v3s16 p = timer.position;
-		double trigger_time = m_time + (double)(timer.timeout - timer.elapsed);
+		double trigger_time = getTime() + (double)(timer.timeout - timer.elapsed);
 		auto it = m_timers.emplace(trigger_time, timer);
 		m_iterators.emplace(p, it);
-		if (m_next_trigger_time == -1. || trigger_time < m_next_trigger_time)
+		if (m_next_trigger_time == -1. || trigger_time < m_next_trigger_time) {
 			m_next_trigger_time = trigger_time;
+			schedule();
+		}
 	}
 	// Deletes old timer and sets a new one
 	inline void set(const NodeTimer &timer) {
@@ -96,12 +138,35 @@ class NodeTimerList
 		m_next_trigger_time = -1.;
 	}
 
-	// Move forward in time, returns elapsed timers
+	// Follow the time of the scheduler instead of being stepped
+	void attach(NodeTimerScheduler *scheduler, v3s16 blockpos);
+	// Stop following the scheduler, the time stands still until the next step
+	void detach();
+	bool isAttached() const { return m_scheduler != nullptr; }
+
+	// Move forward in time, returns elapsed timers (detaches the list)
 	std::vector<NodeTimer> step(float dtime);
+	// Returns the timers that elapsed by now
+	std::vector<NodeTimer> popElapsed();
 
 private:
+	double getTime() const {
+		return m_scheduler ? m_scheduler->getTime() - m_time_offset : m_time;
+	}
+	// Tells the scheduler when the next timer is due, unless it already
+	// has the block queued for no later than that
+	void schedule();
+
 	std::multimap<double, NodeTimer> m_timers;
 	std::map<v3s16, std::multimap<double, NodeTimer>::iterator> m_iterators;
 	double m_next_trigger_time = -1.0;
+	// Time of the list if not attached
 	double m_time = 0.0;
+
+	NodeTimerScheduler *m_scheduler = nullptr;
+	// Time of the scheduler minus time of the list, if attached
+	double m_time_offset = 0.0;
+	v3s16 m_blockpos;
+	// Scheduler time of the last entry queued for the block
+	double m_scheduled_time = -1.0;
 };
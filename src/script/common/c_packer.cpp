@@ -23,6 +23,9 @@ extern "C" {
 // Helpers
 //
 
+// strings of this size or more are borrowed by script_pack_borrowing()
+static constexpr size_t BORROW_MIN_LENGTH = 64 * 1024;
+
 // convert negative index to absolute position on Lua stack
 static inline int absidx(lua_State *L, int idx)
 {
@@ -85,6 +88,13 @@ static inline bool suitable_key(lua_State *L, int idx)
 	}
 }
 
+// is the value a string that should be borrowed instead of copied?
+static inline bool should_borrow(lua_State *L, int idx, bool borrow)
+{
+	return borrow && lua_type(L, idx) == LUA_TSTRING &&
+		lua_objlen(L, idx) >= BORROW_MIN_LENGTH;
+}
+
 /**
  * Push core.known_metatables to the stack if it exists.
  * @param L Lua state
@@ -299,10 +309,9 @@ static bool find_packer(lua_State *L, int idx, PackerTuple &out)
  *         reproduces the value (otherwise)
  *
 */
-static VectorRef<PackedInstr> record_object(lua_State *L, int idx, PackedValue &pv,
+static VectorRef<PackedInstr> record_pointer(const void *ptr, PackedValue &pv,
 		std::unordered_map<const void *, s32> &seen)
 {
-	const void *ptr = lua_topointer(L, idx);
 	assert(ptr);
 	auto found = seen.find(ptr);
 	if (found == seen.end()) {
@@ -321,6 +330,12 @@ static VectorRef<PackedInstr> record_object(lua_State *L, int idx, PackedValue &
 	return r;
 }
 
+static inline VectorRef<PackedInstr> record_object(lua_State *L, int idx, PackedValue &pv,
+		std::unordered_map<const void *, s32> &seen)
+{
+	return record_pointer(lua_topointer(L, idx), pv, seen);
+}
+
 /**
  * Pack a single Lua value and add it to the instruction stream.
  *
@@ -329,10 +344,11 @@ static VectorRef<PackedInstr> record_object(lua_State *L, int idx, PackedValue &
  * @param vidx Next free index on the stack as it would look during unpacking. (v = virtual)
  * @param pv target
  * @param seen Map of seen objects (see record_object)
+ * @param borrow Borrow large strings (see script_pack_borrowing)
  * @return reference to the instruction that creates the value
 */
 static VectorRef<PackedInstr> pack_inner(lua_State *L, int idx, int vidx, PackedValue &pv,
-		std::unordered_map<const void *, s32> &seen)
+		std::unordered_map<const void *, s32> &seen, bool borrow)
 {
 #ifndef NDEBUG
 	StackChecker checker(L);
@@ -355,10 +371,21 @@ static VectorRef<PackedInstr> pack_inner(lua_State *L, int idx, int vidx, Packed
 			return r;
 		}
 		case LUA_TSTRING: {
-			auto r = emplace(pv, LUA_TSTRING);
 			size_t len;
 			const char *str = lua_tolstring(L, idx, &len);
 			assert(str);
+			if (should_borrow(L, idx, borrow)) {
+				// strings are interned, so equal ones have the same data pointer
+				auto r = record_pointer(str, pv, seen);
+				if (r)
+					return r;
+				r = emplace(pv, INSTR_PUSHBORROWED);
+				r->sidata1 = pv.borrowed.size();
+				lua_pushvalue(L, idx);
+				pv.borrowed.push_back({str, len, luaL_ref(L, LUA_REGISTRYINDEX)});
+				return r;
+			}
+			auto r = emplace(pv, LUA_TSTRING);
 			r->sdata.assign(str, len);
 			return r;
 		}
@@ -421,9 +448,10 @@ static VectorRef<PackedInstr> pack_inner(lua_State *L, int idx, int vidx, Packed
 		// to be directly set into a table without separately pushing
 		// the key and using SETTABLE.
 		// only works in certain circumstances, hence the check:
-		if (can_set_into(ktype, vtype) && suitable_key(L, -2)) {
+		if (can_set_into(ktype, vtype) && suitable_key(L, -2) &&
+				!should_borrow(L, -1, borrow)) {
 			// push only the value
-			auto rval = pack_inner(L, absidx(L, -1), vidx, pv, seen);
+			auto rval = pack_inner(L, absidx(L, -1), vidx, pv, seen, borrow);
 			vidx++;
 			rval->pop = rval->type != LUA_TTABLE;
 			// where to put it:
@@ -441,9 +469,9 @@ static VectorRef<PackedInstr> pack_inner(lua_State *L, int idx, int vidx, Packed
 			vidx--;
 		} else {
 			// push the key and value
-			pack_inner(L, absidx(L, -2), vidx, pv, seen);
+			pack_inner(L, absidx(L, -2), vidx, pv, seen, borrow);
 			vidx++;
-			pack_inner(L, absidx(L, -1), vidx, pv, seen);
+			pack_inner(L, absidx(L, -1), vidx, pv, seen, borrow);
 			vidx++;
 			// push an instruction to set them
 			auto ri1 = emplace(pv, INSTR_SETTABLE);
@@ -481,12 +509,29 @@ PackedValue *script_pack(lua_State *L, int idx)
 
 	PackedValue pv;
 	std::unordered_map<const void *, s32> seen;
-	pack_inner(L, idx, 1, pv, seen);
+	pack_inner(L, idx, 1, pv, seen, false);
 
 	// allocate last for exception safety
 	return new PackedValue(std::move(pv));
 }
 
+PackedValue *script_pack_borrowing(lua_State *L, int idx)
+{
+	if (idx < 0)
+		idx = absidx(L, idx);
+
+	PackedValue pv;
+	std::unordered_map<const void *, s32> seen;
+	try {
+		pack_inner(L, idx, 1, pv, seen, true);
+	} catch (...) {
+		script_release_borrowed(L, &pv);
+		throw;
+	}
+
+	return new PackedValue(std::move(pv));
+}
+
 //
 // Unpacking implementation
 //
@@ -534,6 +579,13 @@ void script_unpack(lua_State *L, PackedValue *pv)
 				lua_pushinteger(L, i.sidata1);
 				lua_rawget(L, top);
 				break;
+			case INSTR_PUSHBORROWED: {
+				// read directly from the packing Lua state
+				const auto &b = pv->borrowed.at(i.sidata1);
+				sanity_check(b.data);
+				lua_pushlstring(L, b.data, b.len);
+				break;
+			}
 			case INSTR_SETMETATABLE:
 				if (get_known_lua_metatables(L)) {
 					lua_getfield(L, -1, i.sdata.c_str());
@@ -604,6 +656,15 @@ void script_unpack(lua_State *L, PackedValue *pv)
 	lua_remove(L, top);
 }
 
+void script_release_borrowed(lua_State *L, PackedValue *pv)
+{
+	assert(pv);
+	for (auto &b : pv->borrowed) {
+		luaL_unref(L, LUA_REGISTRYINDEX, b.ref);
+		b.data = nullptr;
+	}
+}
+
 //
 // PackedValue
 //
@@ -647,6 +708,9 @@ void script_dump_packed(const PackedValue *val)
 			case INSTR_SETMETATABLE:
 				printf("SETMETATABLE(%s)", i.sdata.c_str());
 				break;
+			case INSTR_PUSHBORROWED:
+				printf("PUSHBORROWED(%d bytes)", (int)val->borrowed[i.sidata1].len);
+				break;
 			case LUA_TNIL:
 				printf("nil");
 				break;
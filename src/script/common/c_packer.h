@@ -23,6 +23,7 @@ extern "C" {
 #define INSTR_POP          (-11)
 #define INSTR_PUSHREF      (-12)
 #define INSTR_SETMETATABLE (-13)
+#define INSTR_PUSHBORROWED (-14)
 
 /**
  * Represents a single instruction that pushes a new value or operates with existing ones.
@@ -45,6 +46,7 @@ struct PackedInstr
 				SETTABLE: key index | value index
 				POP: indices to remove
 				PUSHREF: index of referenced instr | unused
+				PUSHBORROWED: index into PackedValue::borrowed | unused
 				otherwise w/ set_into: numeric key | unused
 			*/
 			s32 sidata1, sidata2;
@@ -70,7 +72,18 @@ struct PackedInstr
  */
 struct PackedValue
 {
+	/*
+		A large string that is read directly from the Lua state that packed it
+		instead of being copied. A reference in its registry keeps it alive.
+	*/
+	struct BorrowedString {
+		const char *data;
+		size_t len;
+		int ref;
+	};
+
 	std::vector<PackedInstr> i;
+	std::vector<BorrowedString> borrowed;
 	// Indicates whether there are any userdata pointers that need to be deallocated
 	bool contains_userdata = false;
 
@@ -106,9 +119,19 @@ void script_register_packer(lua_State *L, const char *regname,
 
 // Pack a Lua value
 PackedValue *script_pack(lua_State *L, int idx);
+/*
+ * Pack a Lua value, but borrow large strings instead of copying them.
+ * Until script_release_borrowed() is called with the same Lua state the value
+ * holds references into it, so this is only suitable for values that are
+ * handed back to the packing side once they were unpacked.
+ */
+PackedValue *script_pack_borrowing(lua_State *L, int idx);
 // Unpack a Lua value (left on top of stack)
 // Note that this may modify the PackedValue, reusability is not guaranteed!
 void script_unpack(lua_State *L, PackedValue *val);
+// Drop the references of a value packed by script_pack_borrowing(),
+// afterwards it can't be unpacked anymore
+void script_release_borrowed(lua_State *L, PackedValue *val);
 
 // Dump contents of PackedValue to stdout for debugging
 void script_dump_packed(const PackedValue *val);
@@ -17,6 +17,7 @@ extern "C" {
 #include "config.h"
 #include "filesys.h"
 #include "porting.h"
+#include "settings.h"
 #include "common/c_internal.h"
 #include "common/c_packer.h"
 #if CHECK_CLIENT_BUILD()
@@ -72,6 +73,11 @@ void AsyncEngine::initialize(unsigned int numEngines)
 {
 	initDone = true;
 
+	if (server) {
+		resultTimeBudget = g_settings->getFloat("async_result_time_budget",
+			0.0f, 1000.0f) * 1000;
+	}
+
 	if (numEngines == 0) {
 		// Leave one core for the main thread and one for whatever else
 		autoscaleMaxWorkers = Thread::getNumberOfProcessors();
@@ -102,8 +108,9 @@ u32 AsyncEngine::queueAsyncJob(std::string &&func, std::string &&params,
 	MutexAutoLock autolock(jobQueueMutex);
 	u32 jobId = jobIdCounter++;
 
-	jobQueue.emplace_back();
-	auto &to_add = jobQueue.back();
+	auto &queue = jobQueue[0];
+	queue.emplace_back();
+	auto &to_add = queue.back();
 	to_add.id = jobId;
 	to_add.function = std::move(func);
 	to_add.params = std::move(params);
@@ -114,13 +121,14 @@ u32 AsyncEngine::queueAsyncJob(std::string &&func, std::string &&params,
 }
 
 u32 AsyncEngine::queueAsyncJob(std::string &&func, PackedValue *params,
-		const std::string &mod_origin)
+		const std::string &mod_origin, int priority)
 {
 	MutexAutoLock autolock(jobQueueMutex);
 	u32 jobId = jobIdCounter++;
 
-	jobQueue.emplace_back();
-	auto &to_add = jobQueue.back();
+	auto &queue = jobQueue[priority];
+	queue.emplace_back();
+	auto &to_add = queue.back();
 	to_add.id = jobId;
 	to_add.function = std::move(func);
 	to_add.params_ext.reset(params);
@@ -130,6 +138,28 @@ u32 AsyncEngine::queueAsyncJob(std::string &&func, PackedValue *params,
 	return jobId;
 }
 
+u32 AsyncEngine::queueAsyncJobs(const std::string &func,
+		std::vector<std::unique_ptr<PackedValue>> &&params,
+		const std::string &mod_origin, int priority)
+{
+	MutexAutoLock autolock(jobQueueMutex);
+	u32 firstId = jobIdCounter;
+
+	auto &queue = jobQueue[priority];
+	for (auto &param : params) {
+		queue.emplace_back();
+		auto &to_add = queue.back();
+		to_add.id = jobIdCounter++;
+		to_add.function = func;
+		to_add.params_ext = std::move(param);
+		to_add.mod_origin = mod_origin;
+	}
+
+	if (!params.empty())
+		jobQueueCounter.post(params.size());
+	return firstId;
+}
+
 /******************************************************************************/
 bool AsyncEngine::getJob(LuaJobInfo *job)
 {
@@ -139,8 +169,11 @@ bool AsyncEngine::getJob(LuaJobInfo *job)
 	bool retval = false;
 
 	if (!jobQueue.empty()) {
-		*job = std::move(jobQueue.front());
-		jobQueue.pop_front();
+		auto it = jobQueue.begin();
+		*job = std::move(it->second.front());
+		it->second.pop_front();
+		if (it->second.empty())
+			jobQueue.erase(it);
 		retval = true;
 	}
 	jobQueueMutex.unlock();
@@ -166,15 +199,41 @@ void AsyncEngine::step(lua_State *L)
 
 void AsyncEngine::stepJobResults(lua_State *L)
 {
+	// Only handle the results that are there now, the workers keep adding more
+	size_t count;
+	{
+		MutexAutoLock autolock(resultQueueMutex);
+		count = resultQueue.size();
+	}
+	if (count == 0)
+		return;
+
 	int error_handler = PUSH_ERROR_HANDLER(L);
 	lua_getglobal(L, "core");
 
 	ScriptApiBase *script = ModApiBase::getScriptApiBase(L);
 
-	MutexAutoLock autolock(resultQueueMutex);
-	while (!resultQueue.empty()) {
-		LuaJobInfo j = std::move(resultQueue.front());
-		resultQueue.pop_front();
+	const u64 start = porting::getTimeUs();
+	for (; count > 0; count--) {
+		// At least one result is handled per step, so that they can't pile up
+		if (resultTimeBudget && porting::getTimeUs() - start >= resultTimeBudget) {
+			verbosestream << "AsyncEngine: time budget exceeded, deferring "
+				<< count << " results to the next step" << std::endl;
+			break;
+		}
+
+		// Don't hold the lock during the callback, workers would wait for it
+		LuaJobInfo j;
+		{
+			MutexAutoLock autolock(resultQueueMutex);
+			j = std::move(resultQueue.front());
+			resultQueue.pop_front();
+		}
+
+		// The parameters came back along with the result, so that the
+		// strings they borrowed from this Lua state can be released here
+		if (j.params_ext)
+			script_release_borrowed(L, j.params_ext.get());
 
 		lua_getfield(L, -1, "async_event_handler");
 		if (lua_isnil(L, -1))
@@ -409,7 +468,8 @@ void* AsyncWorkerThread::run()
 
 		lua_pop(L, 1);  // Pop retval
 
-		// Put job result
+		// Put job result. A failed job is dropped along with its params_ext,
+		// see LuaJobInfo.
 		if (result == 0)
 			jobDispatcher->putJobResult(std::move(j));
 	}
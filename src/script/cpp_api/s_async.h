@@ -6,6 +6,7 @@
 
 #include <vector>
 #include <deque>
+#include <map>
 #include <unordered_set>
 #include <memory>
 
@@ -31,7 +32,9 @@ struct LuaJobInfo
 	std::string function;
 	// Parameter to be passed to function (serialized)
 	std::string params;
-	// Alternative parameters
+	// Alternative parameters, these are passed back along with the result.
+	// A job that fails is never passed back (on the server its error is
+	// fatal), so the references borrowed by its parameters are not released.
 	std::unique_ptr<PackedValue> params_ext;
 	// Result of function call (serialized)
 	std::string result;
@@ -97,10 +100,22 @@ class AsyncEngine {
 	 * Queue an async job
 	 * @param func Serialized lua function
 	 * @param params Serialized parameters (takes ownership!)
+	 * @param priority Jobs with a higher priority are run first
 	 * @return ID of queued job
 	 */
 	u32 queueAsyncJob(std::string &&func, PackedValue *params,
-			const std::string &mod_origin = "");
+			const std::string &mod_origin = "", int priority = 0);
+
+	/**
+	 * Queue many jobs running the same function at once
+	 * @param func Serialized lua function
+	 * @param params Serialized parameters, one entry per job
+	 * @param priority Jobs with a higher priority are run first
+	 * @return ID of the first job, the others have consecutive IDs
+	 */
+	u32 queueAsyncJobs(const std::string &func,
+			std::vector<std::unique_ptr<PackedValue>> &&params,
+			const std::string &mod_origin = "", int priority = 0);
 
 	/**
 	 * Engine step to process finished jobs
@@ -157,15 +172,19 @@ class AsyncEngine {
 	template <typename T>
 	inline void snapshotJobs(T &to)
 	{
-		for (const auto &it : jobQueue)
-			to.emplace(it.id);
+		for (const auto &queue : jobQueue) {
+			for (const auto &it : queue.second)
+				to.emplace(it.id);
+		}
 	}
 	template <typename T>
 	inline size_t compareJobs(const T &from)
 	{
 		size_t overlap = 0;
-		for (const auto &it : jobQueue)
-			overlap += from.count(it.id);
+		for (const auto &queue : jobQueue) {
+			for (const auto &it : queue.second)
+				overlap += from.count(it.id);
+		}
 		return overlap;
 	}
 
@@ -190,10 +209,13 @@ class AsyncEngine {
 	// Internal counter to create job IDs
 	u32 jobIdCounter = 0;
 
+	// Maximum time spent on result callbacks per step (in us), 0 for no limit
+	u64 resultTimeBudget = 0;
+
 	// Mutex to protect job queue
 	std::mutex jobQueueMutex;
-	// Job queue
-	std::deque<LuaJobInfo> jobQueue;
+	// Job queues by priority, highest first. Empty queues are removed.
+	std::map<int, std::deque<LuaJobInfo>, std::greater<int>> jobQueue;
 
 	// Mutex to protect result queue
 	std::mutex resultQueueMutex;
@@ -394,6 +394,7 @@ void ScriptApiBase::stackDump(std::ostream &o)
 void ScriptApiBase::setOriginDirect(const char *origin)
 {
 	m_last_run_mod = origin ? origin : "??";
+	m_profiler.setOrigin(m_last_run_mod);
 }
 
 void ScriptApiBase::setOriginFromTableRaw(int index, const char *fxn)
@@ -401,6 +402,39 @@ void ScriptApiBase::setOriginFromTableRaw(int index, const char *fxn)
 	lua_State *L = getStack();
 	m_last_run_mod = lua_istable(L, index) ?
 		getstringfield_default(L, index, "mod_origin", "") : "";
+	m_profiler.setOrigin(m_last_run_mod);
+}
+
+void ScriptApiBase::enableProfiler(MetricsBackend *backend)
+{
+	RecursiveMutexAutoLock lock(m_luastackmutex);
+	m_profiler.enable(backend);
+}
+
+void ScriptApiBase::flushProfiler()
+{
+	RecursiveMutexAutoLock lock(m_luastackmutex);
+	m_profiler.flush();
+}
+
+size_t ScriptApiBase::getMemoryUsage()
+{
+	RecursiveMutexAutoLock lock(m_luastackmutex);
+	lua_State *L = getStack();
+	return (size_t)lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
+}
+
+bool ScriptApiBase::stepGarbageCollector(u64 max_time_us)
+{
+	RecursiveMutexAutoLock lock(m_luastackmutex);
+	lua_State *L = getStack();
+	const u64 start = porting::getTimeUs();
+	do {
+		// Smallest possible step, to stay close to the time limit
+		if (lua_gc(L, LUA_GCSTEP, 0))
+			return true;
+	} while (porting::getTimeUs() - start < max_time_us);
+	return false;
 }
 
 /*
@@ -10,6 +10,7 @@
 #include <mutex>
 #include <unordered_map>
 #include "common/helper.h"
+#include "cpp_api/s_profiler.h"
 #include "util/basic_macros.h"
 
 extern "C" {
@@ -101,6 +102,17 @@ class ScriptApiBase : protected LuaHelper {
 	void setOriginDirect(const char *origin);
 	void setOriginFromTableRaw(int index, const char *fxn);
 
+	// Measures the time spent per origin and function from now on
+	void enableProfiler(MetricsBackend *backend);
+	// Adds the measured time to the metrics
+	void flushProfiler();
+
+	// Memory used by the Lua state, in bytes
+	size_t getMemoryUsage();
+	// Runs the incremental garbage collector until the given time has passed
+	// or a cycle was completed. Returns whether a cycle was completed.
+	bool stepGarbageCollector(u64 max_time_us);
+
 	/**
 	 * Returns the currently running mod, only during init time.
 	 * The reason this is insecure is that mods can mess with each others code,
@@ -169,6 +181,7 @@ class ScriptApiBase : protected LuaHelper {
 
 	std::recursive_mutex m_luastackmutex;
 	std::string     m_last_run_mod;
+	ScriptProfiler  m_profiler;
 
 #ifdef SCRIPTAPI_LOCK_DEBUG
 	int             m_lock_recursion_count{};
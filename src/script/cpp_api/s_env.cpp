@@ -12,6 +12,9 @@
 #include "server.h"
 #include "scripting_server.h"
 #include "script/common/c_content.h"
+#include "threading/mutex_auto_lock.h"
+#include <algorithm>
+#include <unordered_map>
 
 /*
 	LuaABM & LuaLBM
@@ -104,7 +107,7 @@ class LuaLBM : public LoadingBlockModifierDef
 	}
 
 	virtual void trigger(ServerEnvironment *env, MapBlock *block,
-		const std::unordered_set<v3s16> &positions, float dtime_s)
+		const std::vector<v3s16> &positions, float dtime_s)
 	{
 		auto *script = env->getScriptIface();
 		script->triggerLBM(m_id, block, positions, dtime_s);
@@ -307,8 +310,7 @@ void ScriptApiEnv::on_emerge_area_completion(
 	Server *server = getServer();
 
 	// This function should be executed with envlock held.
-	// The caller (LuaEmergeAreaCallback in src/script/lua_api/l_env.cpp)
-	// should have obtained the lock.
+	// The caller (run_emerge_area_completions) runs in the server step.
 	// Note that the order of these locks is important!  Envlock must *ALWAYS*
 	// be acquired before attempting to acquire scriptlock, or else ServerThread
 	// will try to acquire scriptlock after it already owns envlock, thus
@@ -343,6 +345,99 @@ void ScriptApiEnv::on_emerge_area_completion(
 	}
 }
 
+void ScriptApiEnv::queue_emerge_area_completion(
+	v3s16 blockpos, int action, ScriptCallbackState *state)
+{
+	MutexAutoLock lock(m_emerge_completions_mutex);
+	m_emerge_completions.push_back({blockpos, action, state});
+}
+
+void ScriptApiEnv::run_emerge_area_completions()
+{
+	std::vector<EmergeAreaCompletion> list;
+	{
+		MutexAutoLock lock(m_emerge_completions_mutex);
+		list.swap(m_emerge_completions);
+	}
+	if (list.empty())
+		return;
+
+	// Group by request, in the order the requests first completed a block
+	// and keeping the order within each request
+	std::unordered_map<ScriptCallbackState *, size_t> group;
+	for (const auto &it : list)
+		group.emplace(it.state, group.size());
+	if (group.size() > 1) {
+		std::stable_sort(list.begin(), list.end(),
+			[&] (const EmergeAreaCompletion &a, const EmergeAreaCompletion &b) {
+				return group[a.state] < group[b.state];
+			});
+	}
+
+	for (size_t begin = 0; begin != list.size(); ) {
+		ScriptCallbackState *state = list[begin].state;
+		size_t end = begin + 1;
+		while (end != list.size() && list[end].state == state)
+			end++;
+
+		assert(state->refcount >= end - begin);
+		if (state->batched) {
+			state->refcount -= end - begin;
+			on_emerge_area_batch_completion(list, begin, end);
+		} else {
+			for (size_t i = begin; i != end; i++) {
+				state->refcount--;
+				on_emerge_area_completion(list[i].blockpos, list[i].action, state);
+			}
+		}
+
+		if (state->refcount == 0)
+			delete state;
+		begin = end;
+	}
+}
+
+void ScriptApiEnv::on_emerge_area_batch_completion(
+	const std::vector<EmergeAreaCompletion> &list, size_t begin, size_t end)
+{
+	Server *server = getServer();
+	ScriptCallbackState *state = list[begin].state;
+
+	SCRIPTAPI_PRECHECKHEADER
+
+	int error_handler = PUSH_ERROR_HANDLER(L);
+
+	lua_rawgeti(L, LUA_REGISTRYINDEX, state->callback_ref);
+	luaL_checktype(L, -1, LUA_TFUNCTION);
+
+	lua_createtable(L, end - begin, 0);
+	lua_createtable(L, end - begin, 0);
+	for (size_t i = begin; i != end; i++) {
+		push_v3s16(L, list[i].blockpos);
+		lua_rawseti(L, -3, i - begin + 1);
+		lua_pushinteger(L, list[i].action);
+		lua_rawseti(L, -2, i - begin + 1);
+	}
+	lua_pushinteger(L, state->refcount);
+	lua_rawgeti(L, LUA_REGISTRYINDEX, state->args_ref);
+
+	setOriginDirect(state->origin.c_str());
+
+	try {
+		PCALL_RES(lua_pcall(L, 4, 0, error_handler));
+	} catch (LuaError &e) {
+		// Note: don't throw here, we still need to run the cleanup code below
+		server->setAsyncFatalError(e);
+	}
+
+	lua_pop(L, 1); // Pop error handler
+
+	if (state->refcount == 0) {
+		luaL_unref(L, LUA_REGISTRYINDEX, state->callback_ref);
+		luaL_unref(L, LUA_REGISTRYINDEX, state->args_ref);
+	}
+}
+
 void ScriptApiEnv::check_for_falling(v3s16 p)
 {
 	SCRIPTAPI_PRECHECKHEADER
@@ -458,7 +553,7 @@ void ScriptApiEnv::triggerABM(int id, v3s16 p, MapNode n,
 }
 
 void ScriptApiEnv::triggerLBM(int id, MapBlock *block,
-		const std::unordered_set<v3s16> &positions, float dtime_s)
+		const std::vector<v3s16> &positions, float dtime_s)
 {
 	SCRIPTAPI_PRECHECKHEADER
 
@@ -7,6 +7,7 @@
 #include "cpp_api/s_base.h"
 #include "irr_v3d.h"
 #include "mapnode.h"
+#include <mutex>
 #include <unordered_set>
 #include <vector>
 
@@ -30,6 +31,15 @@ class ScriptApiEnv : virtual public ScriptApiBase
 	void on_emerge_area_completion(v3s16 blockpos, int action,
 		ScriptCallbackState *state);
 
+	// Queues the completion of a block emerge from core.emerge_area().
+	// Can be called from any thread.
+	void queue_emerge_area_completion(v3s16 blockpos, int action,
+		ScriptCallbackState *state);
+
+	// Runs the callbacks of all queued emerge completions, batched per
+	// core.emerge_area() call. Must be called with the envlock held.
+	void run_emerge_area_completions();
+
 	void check_for_falling(v3s16 p);
 
 	// Called after liquid transform changes
@@ -48,9 +58,21 @@ class ScriptApiEnv : virtual public ScriptApiBase
 			u32 active_object_count, u32 active_object_count_wider);
 
 	void triggerLBM(int id, MapBlock *block,
-		const std::unordered_set<v3s16> &positions, float dtime_s);
+		const std::vector<v3s16> &positions, float dtime_s);
 
 private:
+	struct EmergeAreaCompletion {
+		v3s16 blockpos;
+		int action;
+		ScriptCallbackState *state;
+	};
+
+	void on_emerge_area_batch_completion(
+		const std::vector<EmergeAreaCompletion> &list, size_t begin, size_t end);
+
+	std::mutex m_emerge_completions_mutex;
+	std::vector<EmergeAreaCompletion> m_emerge_completions;
+
 	void readABMs();
 
 	void readLBMs();
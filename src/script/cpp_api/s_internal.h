@@ -65,6 +65,7 @@ class LockChecker {
 #define SCRIPTAPI_PRECHECKHEADER                                               \
 		RecursiveMutexAutoLock scriptlock(this->m_luastackmutex);              \
 		SCRIPTAPI_LOCK_CHECK;                                                  \
+		ScriptProfiler::Scope profiler_scope(this->m_profiler, __FUNCTION__);  \
 		realityCheck();                                                        \
 		lua_State *L = getStack();                                             \
 		assert(lua_checkstack(L, 20));                                         \
@@ -0,0 +1,103 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2024 Luanti Authors
+
+#include "cpp_api/s_profiler.h"
+#include "cpp_api/s_base.h"
+#include "porting.h"
+#include <cassert>
+
+void ScriptProfiler::enable(MetricsBackend *backend)
+{
+	assert(m_stack.empty());
+	m_backend = backend;
+}
+
+void ScriptProfiler::enterRaw(const char *fxn)
+{
+	const u64 now = porting::getTimeNs();
+	mark(now);
+	m_stack.push_back(Frame{fxn, nullptr, 0});
+}
+
+void ScriptProfiler::leaveRaw()
+{
+	if (m_stack.empty())
+		return;
+	mark(porting::getTimeNs());
+	// Nobody claimed the call, so it was builtin doing the work
+	if (!m_stack.back().entry)
+		attribute(getEntry(m_stack.back().fxn, BUILTIN_MOD_NAME));
+	m_stack.pop_back();
+}
+
+void ScriptProfiler::setOriginRaw(const std::string &mod)
+{
+	if (m_stack.empty())
+		return;
+	mark(porting::getTimeNs());
+	attribute(getEntry(m_stack.back().fxn, mod.empty() ? OTHER_MOD_LABEL : mod));
+}
+
+void ScriptProfiler::mark(u64 now)
+{
+	if (!m_stack.empty()) {
+		Frame &frame = m_stack.back();
+		if (frame.entry)
+			frame.entry->time_ns += now - m_last_mark;
+		else
+			frame.pending_ns += now - m_last_mark;
+	}
+	m_last_mark = now;
+}
+
+void ScriptProfiler::attribute(Entry *e)
+{
+	Frame &frame = m_stack.back();
+	if (frame.entry == e)
+		return;
+	// The lookup of the callback belongs to the callback that was looked up
+	e->time_ns += frame.pending_ns;
+	e->calls++;
+	frame.entry = e;
+	frame.pending_ns = 0;
+}
+
+ScriptProfiler::Entry *ScriptProfiler::getEntry(const char *fxn,
+	const std::string &mod)
+{
+	auto &by_mod = m_entries[fxn];
+	auto it = by_mod.find(mod);
+	if (it != by_mod.end())
+		return &it->second;
+
+	if (mod != OTHER_MOD_LABEL && m_mod_labels.count(mod) == 0) {
+		if (m_mod_labels.size() >= MAX_MOD_LABELS)
+			return getEntry(fxn, OTHER_MOD_LABEL);
+		m_mod_labels.insert(mod);
+	}
+
+	Entry &e = by_mod[mod];
+	e.time_counter = m_backend->addCounter("minetest_script_callback_time",
+		"Time spent in script callbacks (in microseconds)",
+		{{"mod", mod}, {"callback", fxn}});
+	e.calls_counter = m_backend->addCounter("minetest_script_callback_calls",
+		"Number of script callbacks run",
+		{{"mod", mod}, {"callback", fxn}});
+	return &e;
+}
+
+void ScriptProfiler::flush()
+{
+	for (auto &by_fxn : m_entries) {
+		for (auto &it : by_fxn.second) {
+			Entry &e = it.second;
+			if (e.calls == 0 && e.time_ns == 0)
+				continue;
+			e.time_counter->increment(e.time_ns / 1000.0);
+			e.calls_counter->increment(e.calls);
+			e.time_ns = 0;
+			e.calls = 0;
+		}
+	}
+}
@@ -0,0 +1,119 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2024 Luanti Authors
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "irrlichttypes.h"
+#include "util/basic_macros.h"
+#include "util/metricsbackend.h"
+
+/*
+	Measures the wall time spent in a script environment, split up by the
+	mod that is running (the origin, see ScriptApiBase::setOriginDirect) and
+	the script API function that called into Lua (e.g. "environment_Step").
+
+	Time of nested calls is only counted for the innermost one, so the
+	numbers add up to the total time spent in Lua.
+	All methods must be called with the script lock held.
+*/
+class ScriptProfiler
+{
+public:
+	ScriptProfiler() = default;
+	DISABLE_CLASS_COPY(ScriptProfiler);
+
+	// Starts collecting, the counters are created on the given backend
+	void enable(MetricsBackend *backend);
+	bool isEnabled() const { return m_backend != nullptr; }
+
+	// Returns whether the call is being measured
+	inline bool enter(const char *fxn)
+	{
+		if (!m_backend)
+			return false;
+		enterRaw(fxn);
+		return true;
+	}
+
+	inline void leave()
+	{
+		if (m_backend)
+			leaveRaw();
+	}
+
+	// Called when the origin changes during a call
+	inline void setOrigin(const std::string &mod)
+	{
+		if (m_backend)
+			setOriginRaw(mod);
+	}
+
+	// Adds the collected time to the metrics counters
+	void flush();
+
+	// Any string can be set as origin from Lua (core.set_last_run_mod), so
+	// only this many distinct mod labels are created. Time of further
+	// origins is counted under OTHER_MOD_LABEL.
+	static constexpr size_t MAX_MOD_LABELS = 1024;
+	static constexpr const char *OTHER_MOD_LABEL = "??";
+
+	// Measures the call for as long as it is in scope
+	class Scope
+	{
+	public:
+		Scope(ScriptProfiler &profiler, const char *fxn) :
+			m_profiler(profiler), m_active(profiler.enter(fxn))
+		{}
+
+		~Scope()
+		{
+			if (m_active)
+				m_profiler.leave();
+		}
+
+		DISABLE_CLASS_COPY(Scope);
+
+	private:
+		ScriptProfiler &m_profiler;
+		const bool m_active;
+	};
+
+private:
+	struct Entry {
+		MetricCounterPtr time_counter;
+		MetricCounterPtr calls_counter;
+		u64 time_ns = 0;
+		u32 calls = 0;
+	};
+
+	struct Frame {
+		const char *fxn;
+		// nullptr until the origin is known
+		Entry *entry;
+		// Time spent before the origin was known
+		u64 pending_ns;
+	};
+
+	void enterRaw(const char *fxn);
+	void leaveRaw();
+	void setOriginRaw(const std::string &mod);
+
+	// Charges the time since the last mark to the innermost call
+	void mark(u64 now);
+	// Makes e the entry the innermost call is charged to, which counts as a
+	// call unless it already was
+	void attribute(Entry *e);
+	Entry *getEntry(const char *fxn, const std::string &mod);
+
+	MetricsBackend *m_backend = nullptr;
+	// function name -> mod name -> entry
+	std::unordered_map<const char *, std::unordered_map<std::string, Entry>> m_entries;
+	std::unordered_set<std::string> m_mod_labels;
+	std::vector<Frame> m_stack;
+	u64 m_last_mark = 0;
+};
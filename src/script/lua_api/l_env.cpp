@@ -27,6 +27,7 @@
 #include "server/luaentity_sao.h"
 #include "server/player_sao.h"
 #include "util/string.h"
+#include "util/enum_string.h"
 #include "translation.h"
 #if CHECK_CLIENT_BUILD()
 #include "client/client.h"
@@ -141,18 +142,10 @@ void LuaEmergeAreaCallback(v3s16 blockpos, EmergeAction action, void *param)
 	ScriptCallbackState *state = (ScriptCallbackState *)param;
 	assert(state != NULL);
 	assert(state->script != NULL);
-	assert(state->refcount > 0);
 
-	// state must be protected by envlock
-	Server *server = state->script->getServer();
-	Server::EnvAutoLock envlock(server);
-
-	state->refcount--;
-
-	state->script->on_emerge_area_completion(blockpos, action, state);
-
-	if (state->refcount == 0)
-		delete state;
+	// Runs on an emerge thread. The callbacks are run from the server step,
+	// so the emerge threads don't contend for the envlock once per block.
+	state->script->queue_emerge_area_completion(blockpos, action, state);
 }
 
 /* Exported functions */
@@ -191,15 +184,17 @@ int ModApiEnv::l_bulk_set_node(lua_State *L)
 
 	MapNode n = readnode(L, 2);
 
-	// Do it
-	bool succeeded = true;
+	std::vector<v3s16> positions;
+	positions.reserve(len);
 	for (s32 i = 1; i <= len; i++) {
 		lua_rawgeti(L, 1, i);
-		if (!env->setNode(read_v3s16(L, -1), n))
-			succeeded = false;
+		positions.push_back(read_v3s16(L, -1));
 		lua_pop(L, 1);
 	}
 
+	// Do it
+	bool succeeded = env->bulkSetNode(positions, n);
+
 	lua_pushboolean(L, succeeded);
 	return 1;
 }
@@ -250,15 +245,17 @@ int ModApiEnv::l_bulk_swap_node(lua_State *L)
 
 	MapNode n = readnode(L, 2);
 
-	// Do it
-	bool succeeded = true;
+	std::vector<v3s16> positions;
+	positions.reserve(len);
 	for (s32 i = 1; i <= len; i++) {
 		lua_rawgeti(L, 1, i);
-		if (!env->swapNode(read_v3s16(L, -1), n))
-			succeeded = false;
+		positions.push_back(read_v3s16(L, -1));
 		lua_pop(L, 1);
 	}
 
+	// Do it
+	bool succeeded = env->bulkSetNode(positions, n, true);
+
 	lua_pushboolean(L, succeeded);
 	return 1;
 }
@@ -318,6 +315,93 @@ int ModApiEnv::l_get_node_light(lua_State *L)
 	return 1;
 }
 
+// Reads the nodes for the bulk_get_* functions, which take either a list of
+// positions at idx or an area from idx and idx + 1.
+// Returns the index of the next argument.
+int ModApiEnv::readBulkNodes(lua_State *L, int idx, Map &map,
+	std::vector<MapNode> &nodes)
+{
+	luaL_checktype(L, idx, LUA_TTABLE);
+
+	if (lua_istable(L, idx + 1)) {
+		v3s16 minp = read_v3s16(L, idx);
+		v3s16 maxp = read_v3s16(L, idx + 1);
+		sortBoxVerticies(minp, maxp);
+		checkArea(minp, maxp);
+
+		// Same order as VoxelArea:index()
+		const VoxelArea area(minp, maxp);
+		nodes.resize(area.getVolume());
+		map.forEachNodeInArea(minp, maxp, [&] (v3s16 p, MapNode n) -> bool {
+			nodes[area.index(p)] = n;
+			return true;
+		});
+		return idx + 2;
+	}
+
+	const size_t len = lua_objlen(L, idx);
+	nodes.reserve(len);
+	for (size_t i = 1; i <= len; i++) {
+		lua_rawgeti(L, idx, i);
+		nodes.push_back(map.getNode(read_v3s16(L, -1)));
+		lua_pop(L, 1);
+	}
+	return idx + 1;
+}
+
+// bulk_get_node_data({pos1, pos2, ...}) or bulk_get_node_data(minp, maxp)
+// -> content_ids, param1s, param2s
+int ModApiEnv::l_bulk_get_node_data(lua_State *L)
+{
+	GET_PLAIN_ENV_PTR;
+
+	std::vector<MapNode> nodes;
+	readBulkNodes(L, 1, env->getMap(), nodes);
+
+	const int n = nodes.size();
+	lua_createtable(L, n, 0);
+	lua_createtable(L, n, 0);
+	lua_createtable(L, n, 0);
+	for (int i = 0; i < n; i++) {
+		lua_pushinteger(L, nodes[i].getContent());
+		lua_rawseti(L, -4, i + 1);
+		lua_pushinteger(L, nodes[i].getParam1());
+		lua_rawseti(L, -3, i + 1);
+		lua_pushinteger(L, nodes[i].getParam2());
+		lua_rawseti(L, -2, i + 1);
+	}
+	return 3;
+}
+
+// bulk_get_node_light({pos1, pos2, ...}, timeofday)
+// or bulk_get_node_light(minp, maxp, timeofday)
+// timeofday: nil = current time, 0 = night, 0.5 = day
+int ModApiEnv::l_bulk_get_node_light(lua_State *L)
+{
+	GET_PLAIN_ENV_PTR;
+
+	std::vector<MapNode> nodes;
+	int idx = readBulkNodes(L, 1, env->getMap(), nodes);
+
+	u32 time_of_day = env->getTimeOfDay();
+	if (lua_isnumber(L, idx))
+		time_of_day = 24000.0 * lua_tonumber(L, idx);
+	time_of_day %= 24000;
+	u32 dnr = time_to_daynight_ratio(time_of_day, true);
+
+	const NodeDefManager *ndef = env->getGameDef()->ndef();
+	const int n = nodes.size();
+	lua_createtable(L, n, 0);
+	for (int i = 0; i < n; i++) {
+		if (nodes[i].getContent() == CONTENT_IGNORE)
+			lua_pushboolean(L, false);
+		else
+			lua_pushinteger(L, nodes[i].getLightBlend(dnr,
+				ndef->getLightingFlags(nodes[i])));
+		lua_rawseti(L, -2, i + 1);
+	}
+	return 1;
+}
 
 // get_natural_light(pos, timeofday)
 // pos = {x=num, y=num, z=num}
@@ -742,6 +826,146 @@ int ModApiEnv::l_get_objects_in_area(lua_State *L)
 	return 1;
 }
 
+// query_objects_inside_radius(pos, radius, fields)
+int ModApiEnv::l_query_objects_inside_radius(lua_State *L)
+{
+	GET_ENV_PTR;
+
+	v3f pos = checkFloatPos(L, 1);
+	float radius = readParam<float>(L, 2) * BS;
+	std::vector<ServerActiveObject *> objs;
+
+	auto include_obj_cb = [](ServerActiveObject *obj){ return !obj->isGone(); };
+	env->getObjectsInsideRadius(objs, pos, radius, include_obj_cb);
+
+	return pushObjectQuery(L, 3, objs);
+}
+
+// query_objects_in_area(minp, maxp, fields)
+int ModApiEnv::l_query_objects_in_area(lua_State *L)
+{
+	GET_ENV_PTR;
+
+	v3f minp = read_v3f(L, 1) * BS;
+	v3f maxp = read_v3f(L, 2) * BS;
+	aabb3f box(minp, maxp);
+	box.repair();
+	std::vector<ServerActiveObject *> objs;
+
+	auto include_obj_cb = [](ServerActiveObject *obj){ return !obj->isGone(); };
+	env->getObjectsInArea(objs, box, include_obj_cb);
+
+	return pushObjectQuery(L, 3, objs);
+}
+
+enum ObjectQueryField : int {
+	OQF_ID,
+	OQF_OBJECT,
+	OQF_POS,
+	OQF_VELOCITY,
+	OQF_NAME,
+	OQF_IS_PLAYER,
+	OQF_HP,
+	OQF_ARMOR_GROUPS,
+};
+
+static const EnumString es_ObjectQueryField[] = {
+	{OQF_ID, "id"},
+	{OQF_OBJECT, "object"},
+	{OQF_POS, "pos"},
+	{OQF_VELOCITY, "velocity"},
+	{OQF_NAME, "name"},
+	{OQF_IS_PLAYER, "is_player"},
+	{OQF_HP, "hp"},
+	{OQF_ARMOR_GROUPS, "armor_groups"},
+	{0, nullptr},
+};
+
+// Returns a table with one list per field name in the list at idx,
+// all in the same order as objs
+int ModApiEnv::pushObjectQuery(lua_State *L, int idx,
+	const std::vector<ServerActiveObject *> &objs)
+{
+	luaL_checktype(L, idx, LUA_TTABLE);
+	ScriptApiBase *script = getScriptApiBase(L);
+
+	const int n = objs.size();
+	// push must be (ServerActiveObject *obj) -> void and push one value
+	auto fill = [&] (auto &&push) {
+		lua_createtable(L, n, 0);
+		for (int i = 0; i < n; i++) {
+			push(objs[i]);
+			lua_rawseti(L, -2, i + 1);
+		}
+	};
+
+	lua_newtable(L);
+	const size_t nfields = lua_objlen(L, idx);
+	for (size_t f = 1; f <= nfields; f++) {
+		lua_rawgeti(L, idx, f);
+		std::string_view name = readParam<std::string_view>(L, -1);
+		int field;
+		if (!string_to_enum(es_ObjectQueryField, field, name))
+			throw LuaError("Unknown object field: " + std::string(name));
+
+		switch (field) {
+		case OQF_ID:
+			fill([&] (ServerActiveObject *obj) {
+				lua_pushinteger(L, obj->getId());
+			});
+			break;
+		case OQF_OBJECT:
+			fill([&] (ServerActiveObject *obj) {
+				script->objectrefGetOrCreate(L, obj);
+			});
+			break;
+		case OQF_POS:
+			fill([&] (ServerActiveObject *obj) {
+				pushFloatPos(L, obj->getBasePosition());
+			});
+			break;
+		case OQF_VELOCITY:
+			fill([&] (ServerActiveObject *obj) {
+				v3f vel;
+				if (obj->getType() == ACTIVEOBJECT_TYPE_LUAENTITY)
+					vel = static_cast<LuaEntitySAO *>(obj)->getVelocity();
+				else if (obj->getType() == ACTIVEOBJECT_TYPE_PLAYER)
+					vel = static_cast<PlayerSAO *>(obj)->getPlayer()->getSpeed();
+				pushFloatPos(L, vel);
+			});
+			break;
+		case OQF_NAME:
+			fill([&] (ServerActiveObject *obj) {
+				if (obj->getType() == ACTIVEOBJECT_TYPE_LUAENTITY)
+					lua_pushstring(L, static_cast<LuaEntitySAO *>(obj)->getName().c_str());
+				else if (obj->getType() == ACTIVEOBJECT_TYPE_PLAYER)
+					lua_pushstring(L, static_cast<PlayerSAO *>(obj)->getPlayer()->getName().c_str());
+				else
+					lua_pushliteral(L, "");
+			});
+			break;
+		case OQF_IS_PLAYER:
+			fill([&] (ServerActiveObject *obj) {
+				lua_pushboolean(L, obj->getType() == ACTIVEOBJECT_TYPE_PLAYER);
+			});
+			break;
+		case OQF_HP:
+			fill([&] (ServerActiveObject *obj) {
+				lua_pushinteger(L, obj->getHP());
+			});
+			break;
+		case OQF_ARMOR_GROUPS:
+			fill([&] (ServerActiveObject *obj) {
+				push_groups(L, obj->getArmorGroups());
+			});
+			break;
+		}
+		// result[name] = list
+		lua_rawset(L, -3);
+	}
+	return 1;
+}
+
 // set_timeofday(val)
 // val = 0...1
 int ModApiEnv::l_set_timeofday(lua_State *L)
@@ -1177,7 +1401,7 @@ int ModApiEnv::l_load_area(lua_State *L)
 	return 0;
 }
 
-// emerge_area(p1, p2, [callback, context])
+// emerge_area(p1, p2, [callback, context, batched])
 // emerge mapblocks in area p1..p2, calls callback with context upon completion
 int ModApiEnv::l_emerge_area(lua_State *L)
 {
@@ -1211,6 +1435,7 @@ int ModApiEnv::l_emerge_area(lua_State *L)
 		state->args_ref     = args_ref;
 		state->refcount     = num_blocks;
 		state->origin       = getScriptApiBase(L)->getOrigin();
+		state->batched      = readParam<bool>(L, 5, false);
 	}
 
 	for (s16 z = bpmin.Z; z <= bpmax.Z; z++)
@@ -1394,6 +1619,8 @@ void ModApiEnv::Initialize(lua_State *L, int top)
 	API_FCT(remove_node);
 	API_FCT(get_node_raw);
 	API_FCT(get_node_light);
+	API_FCT(bulk_get_node_data);
+	API_FCT(bulk_get_node_light);
 	API_FCT(get_natural_light);
 	API_FCT(place_node);
 	API_FCT(dig_node);
@@ -1411,6 +1638,8 @@ void ModApiEnv::Initialize(lua_State *L, int top)
 	API_FCT(get_player_by_name);
 	API_FCT(get_objects_in_area);
 	API_FCT(get_objects_inside_radius);
+	API_FCT(query_objects_in_area);
+	API_FCT(query_objects_inside_radius);
 	API_FCT(set_timeofday);
 	API_FCT(get_timeofday);
 	API_FCT(get_gametime);
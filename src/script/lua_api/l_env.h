@@ -8,6 +8,7 @@
 #include "raycast.h"
 
 class ServerScripting;
+class ServerActiveObject;
 
 // base class containing helpers
 class ModApiEnvBase : public ModApiBase {
@@ -74,6 +75,19 @@ class ModApiEnv : public ModApiEnvBase {
 	// timeofday: nil = current time, 0 = night, 0.5 = day
 	static int l_get_node_light(lua_State *L);
 
+	// bulk_get_node_data({pos1, pos2, ...}) or bulk_get_node_data(minp, maxp)
+	// -> content_ids, param1s, param2s
+	static int l_bulk_get_node_data(lua_State *L);
+
+	// bulk_get_node_light({pos1, pos2, ...}, timeofday)
+	// or bulk_get_node_light(minp, maxp, timeofday)
+	// timeofday: nil = current time, 0 = night, 0.5 = day
+	static int l_bulk_get_node_light(lua_State *L);
+
+	// Reads the positions or area for the bulk_get_* functions
+	static int readBulkNodes(lua_State *L, int idx, Map &map,
+		std::vector<MapNode> &nodes);
+
 	// get_natural_light(pos, timeofday)
 	// pos = {x=num, y=num, z=num}
 	// timeofday: nil = current time, 0 = night, 0.5 = day
@@ -142,6 +156,16 @@ class ModApiEnv : public ModApiEnvBase {
 	// get_objects_in_area(pos, minp, maxp)
 	static int l_get_objects_in_area(lua_State *L);
 
+	// query_objects_inside_radius(pos, radius, fields)
+	static int l_query_objects_inside_radius(lua_State *L);
+
+	// query_objects_in_area(minp, maxp, fields)
+	static int l_query_objects_in_area(lua_State *L);
+
+	// Pushes the requested fields of the objects for the query_objects_* functions
+	static int pushObjectQuery(lua_State *L, int idx,
+		const std::vector<ServerActiveObject *> &objs);
+
 	// set_timeofday(val)
 	// val = 0...1
 	static int l_set_timeofday(lua_State *L);
@@ -314,4 +338,6 @@ struct ScriptCallbackState {
 	int args_ref;
 	unsigned int refcount;
 	std::string origin;
+	// Deliver all completions of a server step in one callback
+	bool batched = false;
 };
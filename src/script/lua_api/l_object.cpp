@@ -1133,6 +1133,74 @@ int ObjectRef::l_get_acceleration(lua_State *L)
 	return 1;
 }
 
+// set_movement(self, def)
+int ObjectRef::l_set_movement(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+	ObjectRef *ref = checkObject<ObjectRef>(L, 1);
+	LuaEntitySAO *entitysao = getluaobject(ref);
+	if (entitysao == nullptr)
+		return 0;
+
+	if (lua_isnoneornil(L, 2)) {
+		entitysao->setMovement(std::nullopt);
+		return 0;
+	}
+
+	luaL_checktype(L, 2, LUA_TTABLE);
+	EntityMovement movement;
+	lua_getfield(L, 2, "target");
+	if (!lua_isnil(L, -1))
+		movement.target = checkFloatPos(L, -1);
+	lua_pop(L, 1);
+
+	float f;
+	if (getfloatfield(L, 2, "target_distance", f))
+		movement.target_distance = std::max(f, 0.0f) * BS;
+	if (getfloatfield(L, 2, "speed", f))
+		movement.speed = std::max(f, 0.0f) * BS;
+	if (getfloatfield(L, 2, "gravity", f))
+		movement.gravity = f * BS;
+	if (getfloatfield(L, 2, "jump", f))
+		movement.jump = std::max(f, 0.0f) * BS;
+	if (getfloatfield(L, 2, "buoyancy", f))
+		movement.buoyancy = f * BS;
+	if (getfloatfield(L, 2, "on_step_interval", f))
+		movement.on_step_interval = std::max(f, 0.0f);
+
+	entitysao->setMovement(movement);
+	return 0;
+}
+
+// get_movement(self)
+int ObjectRef::l_get_movement(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+	ObjectRef *ref = checkObject<ObjectRef>(L, 1);
+	LuaEntitySAO *entitysao = getluaobject(ref);
+	if (entitysao == nullptr)
+		return 0;
+
+	const auto &movement = entitysao->getMovement();
+	if (!movement) {
+		lua_pushnil(L);
+		return 1;
+	}
+
+	lua_newtable(L);
+	if (movement->target) {
+		pushFloatPos(L, *movement->target);
+		lua_setfield(L, -2, "target");
+	}
+	setfloatfield(L, -1, "target_distance", movement->target_distance / BS);
+	setfloatfield(L, -1, "speed", movement->speed / BS);
+	setfloatfield(L, -1, "gravity", movement->gravity / BS);
+	setfloatfield(L, -1, "jump", movement->jump / BS);
+	setfloatfield(L, -1, "buoyancy", movement->buoyancy / BS);
+	setfloatfield(L, -1, "on_step_interval", movement->on_step_interval);
+	return 1;
+}
+
 // set_rotation(self, rotation)
 int ObjectRef::l_set_rotation(lua_State *L)
 {
@@ -2879,6 +2947,8 @@ luaL_Reg ObjectRef::methods[] = {
 	// LuaEntitySAO-only
 	luamethod_aliased(ObjectRef, set_acceleration, setacceleration),
 	luamethod_aliased(ObjectRef, get_acceleration, getacceleration),
+	luamethod(ObjectRef, set_movement),
+	luamethod(ObjectRef, get_movement),
 	luamethod_aliased(ObjectRef, set_yaw, setyaw),
 	luamethod_aliased(ObjectRef, get_yaw, getyaw),
 	luamethod(ObjectRef, set_rotation),
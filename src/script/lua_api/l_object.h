@@ -183,6 +183,12 @@ class ObjectRef : public ModApiBase {
 	// get_acceleration(self)
 	static int l_get_acceleration(lua_State *L);
 
+	// set_movement(self, def)
+	static int l_set_movement(lua_State *L);
+
+	// get_movement(self)
+	static int l_get_movement(lua_State *L);
+
 	// set_rotation(self, rotation)
 	static int l_set_rotation(lua_State *L);
 
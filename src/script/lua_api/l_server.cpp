@@ -480,6 +480,20 @@ int ModApiServer::l_get_game_info(lua_State *L)
 	return 1;
 }
 
+// get_transferred_global(name)
+// Unpacks a global saved by ServerScripting::saveGlobals() into this env
+int ModApiServer::l_get_transferred_global(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+	const std::string name = luaL_checkstring(L, 1);
+	const auto &globals = getServer(L)->m_lua_globals_data;
+	auto it = globals.find(name);
+	if (it == globals.end())
+		return 0;
+	script_unpack(L, it->second.get());
+	return 1;
+}
+
 // get_worldpath()
 int ModApiServer::l_get_worldpath(lua_State *L)
 {
@@ -625,7 +639,7 @@ int ModApiServer::l_notify_authentication_modified(lua_State *L)
 	return 0;
 }
 
-// do_async_callback(func, params, mod_origin)
+// do_async_callback(func, params, mod_origin, [priority])
 int ModApiServer::l_do_async_callback(lua_State *L)
 {
 	NO_MAP_LOCK_REQUIRED;
@@ -634,18 +648,71 @@ int ModApiServer::l_do_async_callback(lua_State *L)
 	luaL_checktype(L, 1, LUA_TFUNCTION);
 	luaL_checktype(L, 2, LUA_TTABLE);
 	luaL_checktype(L, 3, LUA_TSTRING);
+	int priority = luaL_optinteger(L, 4, 0);
+	lua_settop(L, 3);
 
 	call_string_dump(L, 1);
 	size_t func_length;
 	const char *serialized_func_raw = lua_tolstring(L, -1, &func_length);
 
-	PackedValue *param = script_pack(L, 2);
+	PackedValue *param = script_pack_borrowing(L, 2);
 
 	std::string mod_origin = readParam<std::string>(L, 3);
 
 	u32 jobId = script->queueAsync(
 		std::string(serialized_func_raw, func_length),
-		param, mod_origin);
+		param, mod_origin, priority);
+
+	lua_settop(L, 0);
+	lua_pushinteger(L, jobId);
+	return 1;
+}
+
+// do_async_batch(func, params_list, mod_origin, [priority])
+int ModApiServer::l_do_async_batch(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+	ServerScripting *script = getScriptApi<ServerScripting>(L);
+
+	luaL_checktype(L, 1, LUA_TFUNCTION);
+	luaL_checktype(L, 2, LUA_TTABLE);
+	luaL_checktype(L, 3, LUA_TSTRING);
+	int priority = luaL_optinteger(L, 4, 0);
+	lua_settop(L, 3);
+
+	call_string_dump(L, 1);
+	size_t func_length;
+	const char *serialized_func_raw = lua_tolstring(L, -1, &func_length);
+
+	// Check all entries before anything is packed: a Lua error unwinds past
+	// the packed values, and the references they borrowed would leak
+	const size_t count = lua_objlen(L, 2);
+	for (size_t i = 1; i <= count; i++) {
+		lua_rawgeti(L, 2, i);
+		luaL_checktype(L, -1, LUA_TTABLE);
+		lua_pop(L, 1);
+	}
+
+	std::string mod_origin = readParam<std::string>(L, 3);
+
+	// Pack everything first, so that an error doesn't leave half a batch queued
+	std::vector<std::unique_ptr<PackedValue>> params;
+	params.reserve(count);
+	try {
+		for (size_t i = 1; i <= count; i++) {
+			lua_rawgeti(L, 2, i);
+			params.emplace_back(script_pack_borrowing(L, -1));
+			lua_pop(L, 1);
+		}
+	} catch (...) {
+		for (auto &param : params)
+			script_release_borrowed(L, param.get());
+		throw;
+	}
+
+	u32 jobId = script->queueAsyncBatch(
+		std::string(serialized_func_raw, func_length),
+		std::move(params), mod_origin, priority);
 
 	lua_settop(L, 0);
 	lua_pushinteger(L, jobId);
@@ -748,6 +815,7 @@ void ModApiServer::Initialize(lua_State *L, int top)
 	API_FCT(notify_authentication_modified);
 
 	API_FCT(do_async_callback);
+	API_FCT(do_async_batch);
 	API_FCT(register_async_dofile);
 	API_FCT(serialize_roundtrip);
 
@@ -763,4 +831,6 @@ void ModApiServer::InitializeAsync(lua_State *L, int top)
 	API_FCT(get_modpath);
 	API_FCT(get_modnames);
 	API_FCT(get_game_info);
+
+	API_FCT(get_transferred_global);
 }
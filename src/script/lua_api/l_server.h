@@ -43,6 +43,9 @@ class ModApiServer : public ModApiBase
 	// get_game_info()
 	static int l_get_game_info(lua_State *L);
 
+	// get_transferred_global(name)
+	static int l_get_transferred_global(lua_State *L);
+
 	// print(text)
 	static int l_print(lua_State *L);
 
@@ -100,9 +103,12 @@ class ModApiServer : public ModApiBase
 	// notify_authentication_modified(name)
 	static int l_notify_authentication_modified(lua_State *L);
 
-	// do_async_callback(func, params, mod_origin)
+	// do_async_callback(func, params, mod_origin, [priority])
 	static int l_do_async_callback(lua_State *L);
 
+	// do_async_batch(func, params_list, mod_origin, [priority])
+	static int l_do_async_batch(lua_State *L);
+
 	// register_async_dofile(path)
 	static int l_register_async_dofile(lua_State *L);
 
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: LGPL-2.1-or-later
 // Copyright (C) 2013 kwolekr, Ryan Kwolek <kwolekr@minetest.net>
 
+#include <cmath>
 #include <map>
 #include "lua_api/l_vmanip.h"
 #include "lua_api/l_mapgen.h"
@@ -13,8 +14,16 @@
 #include "map.h"
 #include "mapblock.h"
 #include "server.h"
+#include "util/enum_string.h"
 #include "voxelalgorithms.h"
 
+static const EnumString es_VoxelManipViewField[] = {
+	{LuaVoxelManipView::CONTENT, "content"},
+	{LuaVoxelManipView::PARAM1, "param1"},
+	{LuaVoxelManipView::PARAM2, "param2"},
+	{0, nullptr},
+};
+
 // garbage collector
 int LuaVoxelManip::gc_object(lua_State *L)
 {
@@ -346,6 +355,21 @@ int LuaVoxelManip::l_set_param2_data(lua_State *L)
 	return 0;
 }
 
+int LuaVoxelManip::l_get_view(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	checkObject<LuaVoxelManip>(L, 1);
+
+	int field = LuaVoxelManipView::CONTENT;
+	if (!lua_isnoneornil(L, 2) &&
+			!string_to_enum(es_VoxelManipViewField, field, luaL_checkstring(L, 2)))
+		throw LuaError("VoxelManip:get_view: invalid field");
+
+	LuaVoxelManipView::create(L, 1, (LuaVoxelManipView::Field)field);
+	return 1;
+}
+
 int LuaVoxelManip::l_update_map(lua_State *L)
 {
 	return 0;
@@ -378,6 +402,19 @@ int LuaVoxelManip::l_get_emerged_area(lua_State *L)
 	return 2;
 }
 
+int LuaVoxelManip::l_set_move_on_transfer(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	LuaVoxelManip *o = checkObject<LuaVoxelManip>(L, 1);
+
+	if (o->is_mapgen_vm)
+		throw LuaError("Cannot transfer mapgen VoxelManip object");
+	o->move_on_transfer = readParam<bool>(L, 2);
+
+	return 0;
+}
+
 int LuaVoxelManip::l_close(lua_State *L)
 {
 	NO_MAP_LOCK_REQUIRED;
@@ -447,6 +484,8 @@ void *LuaVoxelManip::packIn(lua_State *L, int idx)
 
 	if (o->is_mapgen_vm)
 		throw LuaError("nope");
+	if (o->move_on_transfer)
+		return o->vm->takeContents();
 	return o->vm->clone();
 }
 
@@ -478,6 +517,8 @@ void LuaVoxelManip::Register(lua_State *L)
 	lua_register(L, className, create_object);
 
 	script_register_packer(L, className, packIn, packOut);
+
+	LuaVoxelManipView::Register(L);
 }
 
 const char LuaVoxelManip::className[] = "VoxelManip";
@@ -497,8 +538,174 @@ const luaL_Reg LuaVoxelManip::methods[] = {
 	luamethod(LuaVoxelManip, set_light_data),
 	luamethod(LuaVoxelManip, get_param2_data),
 	luamethod(LuaVoxelManip, set_param2_data),
+	luamethod(LuaVoxelManip, get_view),
 	luamethod(LuaVoxelManip, was_modified),
 	luamethod(LuaVoxelManip, get_emerged_area),
+	luamethod(LuaVoxelManip, set_move_on_transfer),
 	luamethod(LuaVoxelManip, close),
 	{0,0}
 };
+
+/*
+	LuaVoxelManipView
+*/
+
+LuaVoxelManipView::LuaVoxelManipView(LuaVoxelManip *vm, int vm_ref, Field field) :
+	m_vm(vm),
+	m_vm_ref(vm_ref),
+	m_field(field)
+{
+}
+
+void LuaVoxelManipView::create(lua_State *L, int vm_idx, Field field)
+{
+	LuaVoxelManip *vm = checkObject<LuaVoxelManip>(L, vm_idx);
+	lua_pushvalue(L, vm_idx);
+	int vm_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+
+	LuaVoxelManipView *o = new LuaVoxelManipView(vm, vm_ref, field);
+	*(void **)(lua_newuserdata(L, sizeof(void *))) = o;
+	luaL_getmetatable(L, className);
+	lua_setmetatable(L, -2);
+}
+
+int LuaVoxelManipView::gc_object(lua_State *L)
+{
+	LuaVoxelManipView *o = *(LuaVoxelManipView **)(lua_touserdata(L, 1));
+	luaL_unref(L, LUA_REGISTRYINDEX, o->m_vm_ref);
+	delete o;
+
+	return 0;
+}
+
+// Returns the 0-based node index for the Lua index at idx, or -1
+static s32 check_view_index(lua_State *L, int idx, const MMVManip *vm)
+{
+	lua_Number n = lua_tonumber(L, idx);
+	// Range check while still a double, casting NaN or out of range
+	// values to an integer is undefined
+	if (n != n || n < 1 || n > vm->m_area.getVolume() || n != std::floor(n))
+		return -1;
+	return (s32)n - 1;
+}
+
+// view[i]
+int LuaVoxelManipView::l_index(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	LuaVoxelManipView *o = checkObject<LuaVoxelManipView>(L, 1);
+
+	if (lua_type(L, 2) != LUA_TNUMBER) {
+		// Method lookup
+		lua_pushvalue(L, 2);
+		lua_rawget(L, lua_upvalueindex(1));
+		return 1;
+	}
+
+	const MMVManip *vm = o->m_vm->vm;
+	s32 i = check_view_index(L, 2, vm);
+	if (i < 0) {
+		lua_pushnil(L);
+		return 1;
+	}
+
+	// Do not push unintialized data to Lua, same as get_data() & co.
+	bool no_data = vm->m_flags[i] & VOXELFLAG_NO_DATA;
+	const MapNode &n = vm->m_data[i];
+	switch (o->m_field) {
+	case CONTENT:
+		lua_pushinteger(L, no_data ? CONTENT_IGNORE : n.getContent());
+		break;
+	case PARAM1:
+		lua_pushinteger(L, no_data ? 0 : n.getParam1());
+		break;
+	case PARAM2:
+		lua_pushinteger(L, no_data ? 0 : n.getParam2());
+		break;
+	}
+	return 1;
+}
+
+// view[i] = value
+int LuaVoxelManipView::l_newindex(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	LuaVoxelManipView *o = checkObject<LuaVoxelManipView>(L, 1);
+	MMVManip *vm = o->m_vm->vm;
+
+	s32 i = check_view_index(L, 2, vm);
+	if (i < 0)
+		throw LuaError("VoxelManipView: index out of range");
+	lua_Integer value = luaL_checkinteger(L, 3);
+
+	MapNode &n = vm->m_data[i];
+	switch (o->m_field) {
+	case CONTENT:
+		if (vm->m_flags[i] & VOXELFLAG_NO_DATA) {
+			// Same outcome as set_data() with the values get_data() returns:
+			// all uninitialized nodes become ignore and the data is present.
+			const u32 volume = vm->m_area.getVolume();
+			for (u32 j = 0; j != volume; j++) {
+				if (vm->m_flags[j] & VOXELFLAG_NO_DATA)
+					vm->m_data[j] = MapNode(CONTENT_IGNORE);
+			}
+			vm->clearFlags(vm->m_area, VOXELFLAG_NO_DATA);
+		}
+		n.setContent(value);
+		break;
+	case PARAM1:
+		n.param1 = value;
+		break;
+	case PARAM2:
+		n.param2 = value;
+		break;
+	}
+	return 0;
+}
+
+// #view
+int LuaVoxelManipView::l_len(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	LuaVoxelManipView *o = checkObject<LuaVoxelManipView>(L, 1);
+	lua_pushinteger(L, o->m_vm->vm->m_area.getVolume());
+	return 1;
+}
+
+// get_field()
+int LuaVoxelManipView::l_get_field(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	LuaVoxelManipView *o = checkObject<LuaVoxelManipView>(L, 1);
+	lua_pushstring(L, enum_to_string(es_VoxelManipViewField, o->m_field));
+	return 1;
+}
+
+void LuaVoxelManipView::Register(lua_State *L)
+{
+	static const luaL_Reg metamethods[] = {
+		{"__gc", gc_object},
+		{"__newindex", l_newindex},
+		{"__len", l_len},
+		{0, 0}
+	};
+	registerClass<LuaVoxelManipView>(L, methods, metamethods);
+
+	// Replace the method table in __index by a function that also handles
+	// numeric indices, keeping the method table as upvalue
+	luaL_getmetatable(L, className);
+	lua_getfield(L, -1, "__index");
+	lua_pushcclosure(L, l_index, 1);
+	lua_setfield(L, -2, "__index");
+	lua_pop(L, 1);
+}
+
+const char LuaVoxelManipView::className[] = "VoxelManipView";
+const luaL_Reg LuaVoxelManipView::methods[] = {
+	luamethod(LuaVoxelManipView, get_field),
+	{0,0}
+};
@@ -18,6 +18,8 @@ class LuaVoxelManip : public ModApiBase
 {
 private:
 	bool is_mapgen_vm = false;
+	// Hand the data over instead of copying it when packed
+	bool move_on_transfer = false;
 
 	static const luaL_Reg methods[];
 
@@ -43,9 +45,13 @@ class LuaVoxelManip : public ModApiBase
 	static int l_get_param2_data(lua_State *L);
 	static int l_set_param2_data(lua_State *L);
 
+	static int l_get_view(lua_State *L);
+
 	static int l_was_modified(lua_State *L);
 	static int l_get_emerged_area(lua_State *L);
 
+	static int l_set_move_on_transfer(lua_State *L);
+
 	static int l_close(lua_State *L);
 
 public:
@@ -68,3 +74,43 @@ class LuaVoxelManip : public ModApiBase
 
 	static const char className[];
 };
+
+/*
+  VoxelManipView: indexed access to one field of the node data of a
+  VoxelManip, without copying it into a Lua table
+ */
+class LuaVoxelManipView : public ModApiBase
+{
+public:
+	enum Field : u8 {
+		CONTENT,
+		PARAM1,
+		PARAM2,
+	};
+
+private:
+	LuaVoxelManip *m_vm;
+	// Registry reference keeping the VoxelManip userdata alive
+	int m_vm_ref;
+	Field m_field;
+
+	static const luaL_Reg methods[];
+
+	static int gc_object(lua_State *L);
+
+	static int l_index(lua_State *L);
+	static int l_newindex(lua_State *L);
+	static int l_len(lua_State *L);
+
+	static int l_get_field(lua_State *L);
+
+public:
+	LuaVoxelManipView(LuaVoxelManip *vm, int vm_ref, Field field);
+
+	// Creates a view on the VoxelManip at index vm_idx and leaves it on top of stack
+	static void create(lua_State *L, int vm_idx, Field field);
+
+	static void Register(lua_State *L);
+
+	static const char className[];
+};
@@ -7,7 +7,6 @@
 #include "server.h"
 #include "settings.h"
 #include "cpp_api/s_internal.h"
-#include "common/c_packer.h"
 #include "lua_api/l_areastore.h"
 #include "lua_api/l_base.h"
 #include "lua_api/l_craft.h"
@@ -42,11 +41,6 @@ EmergeScripting::EmergeScripting(EmergeThread *parent):
 
 	InitializeModApi(L, top);
 
-	auto *data = ModApiBase::getServer(L)->m_lua_globals_data.get();
-	assert(data);
-	script_unpack(L, data);
-	lua_setfield(L, top, "transferred_globals");
-
 	lua_pop(L, 1);
 
 	// Push builtin initialization type
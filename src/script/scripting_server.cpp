@@ -90,9 +90,20 @@ void ServerScripting::saveGlobals()
 	luaL_checktype(L, -1, LUA_TTABLE);
 	lua_getfield(L, -1, "get_globals_to_transfer");
 	lua_call(L, 0, 1);
-	auto *data = script_pack(L, -1);
-	assert(!data->contains_userdata);
-	getServer()->m_lua_globals_data.reset(data);
+	luaL_checktype(L, -1, LUA_TTABLE);
+	// Pack every global on its own, so that they can be unpacked separately
+	auto &globals = getServer()->m_lua_globals_data;
+	globals.clear();
+	lua_pushnil(L);
+	while (lua_next(L, -2) != 0) {
+		// key at index -2 and value at index -1
+		luaL_checktype(L, -2, LUA_TSTRING);
+		std::string name = lua_tostring(L, -2);
+		auto *data = script_pack(L, -1);
+		assert(!data->contains_userdata);
+		globals[name].reset(data);
+		lua_pop(L, 1);
+	}
 	// unset the function
 	lua_pushnil(L);
 	lua_setfield(L, -3, "get_globals_to_transfer");
@@ -121,10 +132,18 @@ void ServerScripting::stepAsync()
 }
 
 u32 ServerScripting::queueAsync(std::string &&serialized_func,
-	PackedValue *param, const std::string &mod_origin)
+	PackedValue *param, const std::string &mod_origin, int priority)
 {
 	return asyncEngine.queueAsyncJob(std::move(serialized_func),
-			param, mod_origin);
+			param, mod_origin, priority);
+}
+
+u32 ServerScripting::queueAsyncBatch(const std::string &serialized_func,
+	std::vector<std::unique_ptr<PackedValue>> &&params,
+	const std::string &mod_origin, int priority)
+{
+	return asyncEngine.queueAsyncJobs(serialized_func,
+			std::move(params), mod_origin, priority);
 }
 
 void ServerScripting::InitializeModApi(lua_State *L, int top)
@@ -179,10 +198,4 @@ void ServerScripting::InitializeAsync(lua_State *L, int top)
 	LuaSecureRandom::Register(L);
 	LuaVoxelManip::Register(L);
 	LuaSettings::Register(L);
-
-	// globals data
-	auto *data = ModApiBase::getServer(L)->m_lua_globals_data.get();
-	assert(data);
-	script_unpack(L, data);
-	lua_setfield(L, top, "transferred_globals");
 }
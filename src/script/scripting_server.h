@@ -48,7 +48,12 @@ class ServerScripting:
 
 	// Pass job to async threads
 	u32 queueAsync(std::string &&serialized_func,
-		PackedValue *param, const std::string &mod_origin);
+		PackedValue *param, const std::string &mod_origin, int priority);
+
+	// Pass many jobs at once, returns the ID of the first one
+	u32 queueAsyncBatch(const std::string &serialized_func,
+		std::vector<std::unique_ptr<PackedValue>> &&params,
+		const std::string &mod_origin, int priority);
 
 protected:
 	// from ScriptApiSecurity:
@@ -359,6 +359,9 @@ Server::~Server()
     if (m_env) {
         EnvAutoLock envlock(this);
 
+        // Deliver the emerge_area() callbacks cancelled by stopping the threads
+        m_script->run_emerge_area_completions();
+
         infostream << "Server: Executing shutdown hooks" << std::endl;
         try {
             m_script->on_shutdown();
@@ -552,6 +555,9 @@ void Server::init()
     // Do this after regular script init is done
     m_script->initAsync();
 
+    if (g_settings->getBool("profiler.callback_metrics"))
+        m_script->enableProfiler(m_metrics_backend.get());
+
     // Register us to receive map edit events
     servermap.addEventReceiver(this);
 
@@ -640,6 +646,8 @@ void Server::AsyncRunStep(float dtime, bool initial_step)
         return;
     }
 
+    const u64 step_start_time = porting::getTimeUs();
+
     {
         // Send blocks to clients
         SendBlocks(dtime);
@@ -656,6 +664,8 @@ void Server::AsyncRunStep(float dtime, bool initial_step)
     */
     m_uptime_counter->increment(dtime);
 
+    m_script->flushProfiler();
+
     /*
         Update time of day and overall game time
     */
@@ -715,7 +725,8 @@ void Server::AsyncRunStep(float dtime, bool initial_step)
         ScopeProfiler sp(g_profiler, "Server: map timer and unload");
         m_env->getMap().timerUpdate(map_timer_and_unload_dtime,
             std::max(g_settings->getFloat("server_unload_unused_data_timeout"), 0.0f),
-            -1);
+            -1, nullptr,
+            g_settings->getFloat("server_compress_unused_data_timeout"));
     }
 
     /*
@@ -1087,6 +1098,13 @@ void Server::AsyncRunStep(float dtime, bool initial_step)
     }
 
     m_shutdown_state.tick(dtime, this);
+
+    {
+        // Collect Lua garbage in the time left until the next step is due
+        EnvAutoLock lock(this);
+        const s64 step_us = porting::getTimeUs() - step_start_time;
+        m_env->stepLuaGC((s64)(getStepSettings().steplen * 1000000) - step_us);
+    }
 }
 
 void Server::Receive(float min_time)
@@ -30,6 +30,7 @@
 #include <list>
 #include <map>
 #include <vector>
+#include <unordered_map>
 #include <unordered_set>
 #include <optional>
 #include <string_view>
@@ -451,8 +452,9 @@ class Server : public con::PeerHandler, public MapEventReceiver,
     // Identical but for mapgen env
     std::vector<std::pair<std::string, std::string>> m_mapgen_init_files;
 
-    // Data transferred into other Lua envs at init time
-    std::unique_ptr<PackedValue> m_lua_globals_data;
+    // Data transferred into other Lua envs, by name of the global.
+    // Read-only once the mods are loaded, each env unpacks what it uses.
+    std::unordered_map<std::string, std::unique_ptr<PackedValue>> m_lua_globals_data;
 
     // Bind address
     Address m_bind_addr;
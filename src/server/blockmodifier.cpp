@@ -3,6 +3,7 @@
 // Copyright (C) 2010-2017 celeron55, Perttu Ahola <celeron55@gmail.com>
 
 #include <algorithm>
+#include <bitset>
 #include "blockmodifier.h"
 #include "serverenvironment.h"
 #include "server.h"
@@ -162,12 +163,13 @@ void ABMHandler::apply(MapBlock *block, int &blocks_scanned, int &abms_run, int
 	bool want_contents_cached = block->contents.empty() && !block->do_not_cache_contents;
 
 	v3s16 p0;
+	u32 i = 0;
 	for(p0.Z=0; p0.Z<MAP_BLOCKSIZE; p0.Z++)
 	for(p0.Y=0; p0.Y<MAP_BLOCKSIZE; p0.Y++)
-	for(p0.X=0; p0.X<MAP_BLOCKSIZE; p0.X++)
+	for(p0.X=0; p0.X<MAP_BLOCKSIZE; p0.X++, i++)
 	{
-		MapNode n = block->getNodeNoCheck(p0);
-		content_t c = n.getContent();
+		// Only the content is needed to decide whether there's anything to do
+		content_t c = block->getContentData()[i];
 
 		// Cache content types as we go
 		if (want_contents_cached && !CONTAINS(block->contents, c)) {
@@ -185,6 +187,7 @@ void ABMHandler::apply(MapBlock *block, int &blocks_scanned, int &abms_run, int
 		if (c >= m_aabms.size() || !m_aabms[c])
 			continue;
 
+		MapNode n = block->getNodeNoCheck(p0);
 		v3s16 p = p0 + block->getPosRelative();
 		for (ActiveABM &aabm : *m_aabms[c]) {
 			if (p.Y < aabm.min_y || p.Y > aabm.max_y)
@@ -396,6 +399,25 @@ void LBMManager::loadIntroductionTimes(const std::string &times,
 
 	infostream << "LBMManager: " << m_lbm_lookup.size() <<
 		" unique times in lookup table" << std::endl;
+
+	buildDispatchTable();
+}
+
+void LBMManager::buildDispatchTable()
+{
+	m_lbm_dispatch.clear();
+
+	// m_lbm_lookup is ordered by time, so the lists end up ordered as well
+	for (const auto &[time, mapping] : m_lbm_lookup) {
+		for (const auto &[c, lbms] : mapping.getMap()) {
+			if (c >= m_lbm_dispatch.size())
+				m_lbm_dispatch.resize(c + 1);
+			ContentLBMs &entry = m_lbm_dispatch[c];
+			for (auto *lbm_def : lbms)
+				entry.lbms.emplace_back(time, lbm_def);
+			entry.latest = time;
+		}
+	}
 }
 
 std::string LBMManager::createIntroductionTimesString()
@@ -448,16 +470,10 @@ std::unordered_map<std::string, u32>
 
 namespace {
 	struct LBMToRun {
-		std::unordered_set<v3s16> p; // node positions
-		std::vector<LoadingBlockModifierDef*> l; // ordered list of LBMs
-
-		template <typename C>
-		void insertLBMs(const C &container) {
-			for (auto &it : container) {
-				if (!CONTAINS(l, it))
-					l.push_back(it);
-			}
-		}
+		content_t c;
+		std::bitset<MapBlock::nodecount> p; // node positions
+		// LBMs to run, a range of the list in the dispatch table
+		const std::pair<u32, LoadingBlockModifierDef *> *begin, *end;
 	};
 }
 
@@ -468,73 +484,83 @@ void LBMManager::applyLBMs(ServerEnvironment *env, MapBlock *block,
 	FATAL_ERROR_IF(!m_query_mode,
 		"attempted to query on non fully set up LBMManager");
 
-	// Collect a list of all LBMs and associated positions
-	std::unordered_map<content_t, LBMToRun> to_run;
+	// Nothing to do unless an LBM was introduced since the block was last
+	// active (LBMs that run at every load always are)
+	if (getLBMsIntroducedAfter(stamp) == m_lbm_lookup.end())
+		return;
 
-	// Note: the iteration count of this outer loop is typically very low, so it's ok.
-	for (auto it = getLBMsIntroducedAfter(stamp); it != m_lbm_lookup.end(); ++it) {
-		v3s16 pos;
-		content_t c;
+	// Collect all contents with LBMs to run and their positions
+	std::vector<LBMToRun> to_run;
+	{
+		const content_t *contents = block->getContentData();
+		const size_t table_size = m_lbm_dispatch.size();
 
-		// Cache previous lookups since it has a high performance penalty.
+		// Cache previous lookups, usually there are long runs of the same content
 		content_t previous_c = CONTENT_IGNORE;
-		const LBMContentMapping::lbm_vector *lbm_list = nullptr;
 		LBMToRun *batch = nullptr;
 
-		for (pos.Z = 0; pos.Z < MAP_BLOCKSIZE; pos.Z++)
-		for (pos.Y = 0; pos.Y < MAP_BLOCKSIZE; pos.Y++)
-		for (pos.X = 0; pos.X < MAP_BLOCKSIZE; pos.X++) {
-			c = block->getNodeNoCheck(pos).getContent();
-
-			bool c_changed = false;
-			if (previous_c != c) {
-				c_changed = true;
-				lbm_list = it->second.lookup(c);
-				if (lbm_list)
-					batch = &to_run[c]; // creates entry
+		for (u32 i = 0; i < MapBlock::nodecount; i++) {
+			const content_t c = contents[i];
+			if (c != previous_c) {
 				previous_c = c;
+				batch = nullptr;
+				if (c >= table_size || m_lbm_dispatch[c].lbms.empty() ||
+						m_lbm_dispatch[c].latest < stamp)
+					continue;
+				for (auto &it : to_run) {
+					if (it.c == c) {
+						batch = &it;
+						break;
+					}
+				}
+				if (!batch) {
+					const auto &lbms = m_lbm_dispatch[c].lbms;
+					auto first = std::lower_bound(lbms.begin(), lbms.end(), stamp,
+						[] (const auto &entry, u32 time) {
+							return entry.first < time;
+						});
+					batch = &to_run.emplace_back();
+					batch->c = c;
+					batch->begin = lbms.data() + (first - lbms.begin());
+					batch->end = lbms.data() + lbms.size();
+				}
 			}
-
-			if (!lbm_list)
-				continue;
-			batch->p.insert(pos);
-			if (c_changed) {
-				batch->insertLBMs(*lbm_list);
-			} else {
-				// we were here before so the list must be filled
-				assert(!batch->l.empty());
-			}
+			if (batch)
+				batch->p.set(i);
 		}
 	}
 
 	// Actually run them
+	std::vector<v3s16> positions;
 	bool first = true;
-	for (auto &[c, batch] : to_run) {
+	for (auto &batch : to_run) {
+		const content_t c = batch.c;
 		if (tracestream) {
-			tracestream << "Running " << batch.l.size() << " LBMs for node "
+			tracestream << "Running " << (batch.end - batch.begin) << " LBMs for node "
 				<< env->getGameDef()->ndef()->get(c).name << " ("
-				<< batch.p.size() << "x) in block " << block->getPos() << std::endl;
+				<< batch.p.count() << "x) in block " << block->getPos() << std::endl;
 		}
-		for (auto &lbm_def : batch.l) {
-			if (!first) {
-				// The fun part: since any LBM call can change the nodes inside of he
-				// block, we have to recheck the positions to see if the wanted node
-				// is still there.
-				// Note that we don't rescan the whole block, we don't want to include new changes.
-				for (auto it2 = batch.p.begin(); it2 != batch.p.end(); ) {
-					if (block->getNodeNoCheck(*it2).getContent() != c)
-						it2 = batch.p.erase(it2);
-					else
-						++it2;
-				}
-			} else {
-				assert(!batch.p.empty());
+		for (auto it = batch.begin; it != batch.end; ++it) {
+			// The fun part: since any LBM call can change the nodes inside of he
+			// block, we have to recheck the positions to see if the wanted node
+			// is still there.
+			// Note that we don't rescan the whole block, we don't want to include new changes.
+			positions.clear();
+			for (u32 i = 0; i < MapBlock::nodecount; i++) {
+				if (!batch.p.test(i))
+					continue;
+				v3s16 pos(i % MAP_BLOCKSIZE, (i / MapBlock::ystride) % MAP_BLOCKSIZE,
+					i / MapBlock::zstride);
+				if (!first && block->getNodeNoCheck(pos).getContent() != c)
+					batch.p.reset(i);
+				else
+					positions.push_back(pos);
 			}
 			first = false;
 
-			if (batch.p.empty())
+			if (positions.empty())
 				break;
-			lbm_def->trigger(env, block, batch.p, dtime_s);
+			it->second->trigger(env, block, positions, dtime_s);
 			if (block->isOrphan())
 				return;
 		}
@@ -7,7 +7,6 @@
 #include <string>
 #include <vector>
 #include <map>
-#include <unordered_set>
 #include <unordered_map>
 
 #include "irr_v3d.h"
@@ -101,10 +100,10 @@ struct LoadingBlockModifierDef
 	/// @brief Called to invoke LBM
 	/// @param env environment
 	/// @param block the block in question
-	/// @param positions set of node positions (block-relative!)
+	/// @param positions node positions (block-relative!), each only once
 	/// @param dtime_s game time since last deactivation
 	virtual void trigger(ServerEnvironment *env, MapBlock *block,
-		const std::unordered_set<v3s16> &positions, float dtime_s) {};
+		const std::vector<v3s16> &positions, float dtime_s) {};
 };
 
 class LBMContentMapping
@@ -117,6 +116,7 @@ class LBMContentMapping
 	void addLBM(LoadingBlockModifierDef *lbm_def, IGameDef *gamedef);
 	const lbm_map::mapped_type *lookup(content_t c) const;
 	const lbm_vector &getList() const { return lbm_list; }
+	const lbm_map &getMap() const { return map; }
 	bool empty() const { return lbm_list.empty(); }
 
 	// This struct owns the LBM pointers.
@@ -165,6 +165,18 @@ class LBMManager
 	// The key of the map is the LBM def's first introduction time.
 	lbm_lookup_map m_lbm_lookup;
 
+	struct ContentLBMs {
+		// Introduction time of the newest LBM
+		u32 latest = 0;
+		// LBMs with their introduction time, ordered by time
+		std::vector<std::pair<u32, LoadingBlockModifierDef *>> lbms;
+	};
+	// m_lbm_lookup flattened into a table indexed by content id, so a block
+	// can be checked in a single pass (filled by loadIntroductionTimes())
+	std::vector<ContentLBMs> m_lbm_dispatch;
+
+	void buildDispatchTable();
+
 	/// @return map of LBM name -> timestamp
 	static std::unordered_map<std::string, u32>
 	parseIntroductionTimesString(const std::string &times);
@@ -0,0 +1,48 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2024 Luanti Authors
+
+#include "entity_movement.h"
+#include "collision.h"
+#include <algorithm>
+
+bool EntityMovement::steer(float dtime, v3f pos, bool in_liquid,
+	v3f &velocity, v3f &acceleration)
+{
+	acceleration.Y = in_liquid ? buoyancy - gravity : -gravity;
+
+	if (!target)
+		return false;
+
+	v3f dir = *target - pos;
+	dir.Y = 0;
+	const f32 distance = dir.getLength();
+	if (distance <= target_distance) {
+		velocity.X = velocity.Z = 0;
+		target.reset();
+		return true;
+	}
+
+	// Don't overshoot the target within one step
+	f32 s = speed;
+	if (dtime > 0)
+		s = std::min(s, distance / dtime);
+	dir *= s / distance;
+	velocity.X = dir.X;
+	velocity.Z = dir.Z;
+	return false;
+}
+
+bool EntityMovement::shouldJump(const collisionMoveResult &result) const
+{
+	if (jump <= 0 || !target || !result.touching_ground)
+		return false;
+
+	// Blocked sideways by a node that was too high to step up on
+	for (const auto &info : result.collisions) {
+		if (info.type == COLLISION_NODE &&
+				(info.axis == COLLISION_AXIS_X || info.axis == COLLISION_AXIS_Z))
+			return true;
+	}
+	return false;
+}
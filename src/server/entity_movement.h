@@ -0,0 +1,45 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2024 Luanti Authors
+
+#pragma once
+
+#include <optional>
+#include "irrlichttypes_bloated.h"
+#include "constants.h"
+
+struct collisionMoveResult;
+
+/*
+	Simple movement of a LuaEntitySAO that is evaluated in C++ every server
+	step, so that mobs don't need a Lua on_step for walking around.
+	See ObjectRef:set_movement() in lua_api.md.
+	Values are in internal units (BS).
+*/
+struct EntityMovement
+{
+	// Walk towards this position, if any
+	std::optional<v3f> target;
+	// The target is reached when it is closer than this horizontally
+	f32 target_distance = 0.5f * BS;
+	// Horizontal speed towards the target
+	f32 speed = 1.0f * BS;
+	// Downwards acceleration
+	f32 gravity = 0.0f;
+	// Upwards velocity when jumping over an obstacle, 0 = never jump
+	f32 jump = 0.0f;
+	// Upwards acceleration while inside a liquid
+	f32 buoyancy = 0.0f;
+	// Minimum time between two calls of on_step, 0 = every server step
+	f32 on_step_interval = 0.0f;
+
+	/*
+		Sets the velocity and acceleration for the next step.
+		Returns true if the target was reached, which clears it.
+	*/
+	bool steer(float dtime, v3f pos, bool in_liquid,
+		v3f &velocity, v3f &acceleration);
+
+	// Whether to jump after the given move
+	bool shouldJump(const collisionMoveResult &result) const;
+};
@@ -8,6 +8,8 @@
 #include "constants.h"
 #include "inventory.h"
 #include "irrlicht_changes/printing.h"
+#include "map.h"
+#include "nodedef.h"
 #include "player_sao.h"
 #include "scripting_server.h"
 #include "server.h"
@@ -143,6 +145,8 @@ void LuaEntitySAO::step(float dtime, bool send_recommended)
 	m_last_sent_position_timer += dtime;
 
 	collisionMoveResult moveresult, *moveresult_p = nullptr;
+	// Whether on_step should be called now, regardless of the interval
+	bool step_event = false;
 
 	// Each frame, parent position is copied if the object is attached, otherwise it's calculated normally
 	// If the object gets detached this comes into effect automatically from the last known origin
@@ -151,6 +155,14 @@ void LuaEntitySAO::step(float dtime, bool send_recommended)
 		m_velocity = v3f(0,0,0);
 		m_acceleration = v3f(0,0,0);
 	} else {
+		if (m_movement) {
+			const v3f pos = getBasePosition();
+			const MapNode n = m_env->getMap().getNode(floatToInt(pos, BS));
+			const bool in_liquid = m_env->getGameDef()->ndef()->get(n).isLiquid();
+			step_event = m_movement->steer(dtime, pos, in_liquid,
+					m_velocity, m_acceleration);
+		}
+
 		if(m_prop.physical){
 			aabb3f box = m_prop.collisionbox;
 			box.MinEdge *= BS;
@@ -168,6 +180,9 @@ void LuaEntitySAO::step(float dtime, bool send_recommended)
 			setBasePosition(p_pos);
 			m_velocity = p_velocity;
 			m_acceleration = p_acceleration;
+
+			if (m_movement && m_movement->shouldJump(moveresult))
+				m_velocity.Y = m_movement->jump;
 		} else {
 			addPos((m_velocity + m_acceleration * 0.5f * dtime) * dtime);
 			m_velocity += dtime * m_acceleration;
@@ -197,7 +212,14 @@ void LuaEntitySAO::step(float dtime, bool send_recommended)
 	}
 
 	if(m_registered) {
-		m_env->getScriptIface()->luaentity_Step(m_id, dtime, moveresult_p);
+		m_step_dtime += dtime;
+		if (!m_movement || step_event ||
+				m_step_dtime >= m_movement->on_step_interval) {
+			// Note: moveresult only covers the last step
+			float step_dtime = m_step_dtime;
+			m_step_dtime = 0.0f;
+			m_env->getScriptIface()->luaentity_Step(m_id, step_dtime, moveresult_p);
+		}
 	}
 
 	if (!send_recommended)
@@ -434,6 +456,11 @@ v3f LuaEntitySAO::getAcceleration()
 	return m_acceleration;
 }
 
+void LuaEntitySAO::setMovement(const std::optional<EntityMovement> &movement)
+{
+	m_movement = movement;
+}
+
 void LuaEntitySAO::setTextureMod(const std::string &mod)
 {
 	if (m_texture_modifier == mod)
@@ -6,6 +6,7 @@
 #pragma once
 
 #include "unit_sao.h"
+#include "entity_movement.h"
 
 class LuaEntitySAO : public UnitSAO
 {
@@ -54,6 +55,8 @@ class LuaEntitySAO : public UnitSAO
 	v3f getVelocity();
 	void setAcceleration(v3f acceleration);
 	v3f getAcceleration();
+	void setMovement(const std::optional<EntityMovement> &movement);
+	const std::optional<EntityMovement> &getMovement() const { return m_movement; }
 
 	void setTextureMod(const std::string &mod);
 	std::string getTextureMod() const;
@@ -89,6 +92,10 @@ class LuaEntitySAO : public UnitSAO
 	v3f m_velocity;
 	v3f m_acceleration;
 
+	std::optional<EntityMovement> m_movement;
+	// Time since on_step was last called
+	float m_step_dtime = 0.0f;
+
 	v3f m_last_sent_position;
 	v3f m_last_sent_velocity;
 	v3f m_last_sent_rotation;
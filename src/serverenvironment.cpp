@@ -189,6 +189,7 @@ ServerEnvironment::ServerEnvironment(std::unique_ptr<ServerMap> map,
 	m_cache_abm_interval = rangelim(g_settings->getFloat("abm_interval"), 0.1f, 30);
 	m_cache_nodetimer_interval = rangelim(g_settings->getFloat("nodetimer_interval"), 0.1f, 1);
 	m_cache_abm_time_budget = g_settings->getFloat("abm_time_budget");
+	m_cache_lua_gc_step_budget = g_settings->getFloat("lua_gc_step_budget");
 
 	m_step_time_counter = mb->addCounter(
 		"minetest_env_step_time", "Time spent in environment step (in microseconds)");
@@ -198,6 +199,17 @@ ServerEnvironment::ServerEnvironment(std::unique_ptr<ServerMap> map,
 
 	m_active_object_gauge = mb->addGauge(
 		"minetest_env_active_objects", "Number of active objects");
+
+	m_lua_memory_gauge = mb->addGauge(
+		"minetest_env_lua_memory", "Memory used by the Lua state (in bytes)");
+
+	m_lua_gc_time_counter = mb->addCounter(
+		"minetest_env_lua_gc_time",
+		"Time spent collecting Lua garbage after the step (in microseconds)");
+
+	m_lua_gc_cycle_counter = mb->addCounter(
+		"minetest_env_lua_gc_cycles",
+		"Number of Lua garbage collection cycles completed after the step");
 }
 
 void ServerEnvironment::init()
@@ -575,6 +587,11 @@ void ServerEnvironment::activateBlock(MapBlock *block)
 	block->step((float)dtime_s, [&](v3s16 p, MapNode n, f32 d) -> bool {
 		return m_script->node_on_timer(p, n, d);
 	});
+	if (block->isOrphan())
+		return;
+
+	// From now on the timers are run by the scheduler
+	block->attachNodeTimers(&m_node_timer_scheduler);
 }
 
 void ServerEnvironment::addActiveBlockModifier(ActiveBlockModifier *abm)
@@ -656,6 +673,82 @@ bool ServerEnvironment::swapNode(v3s16 p, const MapNode &n)
 	return true;
 }
 
+bool ServerEnvironment::bulkSetNode(const std::vector<v3s16> &positions,
+	const MapNode &n, bool swap)
+{
+	const NodeDefManager *ndef = m_server->ndef();
+	const ContentFeatures &cf_new = ndef->get(n);
+	// Callbacks of the new node could observe the nodes set before them,
+	// so keep the exact order of set_node calls
+	const bool new_has_callbacks = !swap && (cf_new.has_on_construct ||
+		cf_new.has_on_destruct || cf_new.has_after_destruct);
+
+	bool succeeded = true;
+	std::vector<v3s16> batch;
+
+	auto flush = [&] () {
+		if (batch.empty())
+			return;
+
+		std::map<v3s16, MapBlock*> modified_blocks;
+		if (!m_map->addNodesAndUpdate(batch, n, modified_blocks, !swap))
+			succeeded = false;
+
+		// Leaves the blocks that were only touched by the lighting
+		for (v3s16 p : batch)
+			modified_blocks.erase(getNodeBlockPos(p));
+
+		// Clients update the lighting around the changed nodes themselves.
+		// The other modified blocks ride along with the first event, so that
+		// they are resent to far players only, like with set_node.
+		for (v3s16 p : batch) {
+			v3s16 blockpos = getNodeBlockPos(p);
+			if (!m_map->getBlockNoCreateNoEx(blockpos))
+				continue;
+
+			MapEditEvent event;
+			event.type = swap ? MEET_SWAPNODE : MEET_ADDNODE;
+			event.n = n;
+			event.setPositionModified(p);
+			for (const auto &it : modified_blocks)
+				event.modified_blocks.push_back(it.first);
+			modified_blocks.clear();
+			m_map->dispatchEvent(event);
+
+			// Update active VoxelManipulator if a mapgen thread
+			m_map->updateVManip(p);
+		}
+		// Only if no event was sent above
+		if (!modified_blocks.empty()) {
+			MapEditEvent event;
+			event.type = MEET_OTHER;
+			event.low_priority = true;
+			event.setModifiedBlocks(modified_blocks);
+			m_map->dispatchEvent(event);
+		}
+		batch.clear();
+	};
+
+	for (v3s16 p : positions) {
+		bool has_callbacks = new_has_callbacks;
+		if (!swap && !has_callbacks) {
+			const ContentFeatures &cf_old = ndef->get(m_map->getNode(p));
+			has_callbacks = cf_old.has_on_destruct || cf_old.has_after_destruct;
+		}
+		if (!has_callbacks) {
+			batch.push_back(p);
+			continue;
+		}
+
+		flush();
+		if (!setNode(p, n))
+			succeeded = false;
+	}
+	flush();
+
+	return succeeded;
+}
+
 u8 ServerEnvironment::findSunlight(v3s16 pos) const
 {
 	// Directions for neighboring nodes with specified order
@@ -930,6 +1023,8 @@ void ServerEnvironment::step(float dtime)
 
 			// Set current time as timestamp (and let it set ChangedFlag)
 			block->setTimestamp(m_game_time);
+
+			block->detachNodeTimers();
 		}
 
 		/*
@@ -998,8 +1093,18 @@ void ServerEnvironment::step(float dtime)
 					MOD_REASON_BLOCK_EXPIRED);
 			}
 
-			// Run node timers
-			block->step(dtime, [&](v3s16 p, MapNode n, f32 d) -> bool {
+			// The block may have been replaced since it was activated
+			if (!block->nodeTimersAttached())
+				block->attachNodeTimers(&m_node_timer_scheduler);
+		}
+
+		// Run node timers, only the blocks that have some due are visited
+		for (const v3s16 &p: m_node_timer_scheduler.step(dtime)) {
+			MapBlock *block = m_map->getBlockNoCreateNoEx(p);
+			if (!block || !block->nodeTimersAttached())
+				continue;
+
+			block->runDueNodeTimers([&](v3s16 p, MapNode n, f32 d) -> bool {
 				return m_script->node_on_timer(p, n, d);
 			});
 		}
@@ -1060,6 +1165,11 @@ void ServerEnvironment::step(float dtime)
 		timer.stop(true);
 	}
 
+	/*
+		Run core.emerge_area() callbacks of blocks emerged since the last step
+	*/
+	m_script->run_emerge_area_completions();
+
 	/*
 		Step script environment (run global on_step())
 	*/
@@ -1149,6 +1259,34 @@ void ServerEnvironment::step(float dtime)
 	m_step_time_counter->increment(end_time - start_time);
 }
 
+void ServerEnvironment::stepLuaGC(s64 spare_us)
+{
+	const size_t memory = m_script->getMemoryUsage();
+	m_lua_memory_gauge->set(memory);
+	g_profiler->avg("ServerEnv: Lua memory [KiB]", memory / 1024);
+
+	// Nothing to do if there was no allocation since the last step, or if
+	// Lua already collected it by itself
+	const bool grown = memory > m_lua_memory_last;
+	m_lua_memory_last = memory;
+	if (m_cache_lua_gc_step_budget <= 0 || !grown)
+		return;
+
+	const s64 budget_us = std::min<s64>(m_cache_lua_gc_step_budget * 1000, spare_us);
+	if (budget_us <= 0)
+		return;
+
+	const u64 start_time = porting::getTimeUs();
+	const bool finished = m_script->stepGarbageCollector(budget_us);
+	const u64 gc_time = porting::getTimeUs() - start_time;
+	m_lua_gc_time_counter->increment(gc_time);
+	g_profiler->avg("ServerEnv: Lua GC after step [ms]", gc_time / 1000.0f);
+	if (finished)
+		m_lua_gc_cycle_counter->increment();
+
+	m_lua_memory_last = m_script->getMemoryUsage();
+}
+
 ServerEnvironment::BlockStatus ServerEnvironment::getBlockStatus(v3s16 blockpos)
 {
 	if (m_active_blocks.contains(blockpos))
@@ -216,6 +216,10 @@ class ServerEnvironment final : public Environment
 	bool setNode(v3s16 p, const MapNode &n);
 	bool removeNode(v3s16 p);
 	bool swapNode(v3s16 p, const MapNode &n);
+	// Same as setNode() (or swapNode()) for each position, but nodes that
+	// need no callbacks are placed together with a single lighting update
+	bool bulkSetNode(const std::vector<v3s16> &positions, const MapNode &n,
+		bool swap = false);
 
 	// Find the daylight value at pos with a Depth First Search
 	u8 findSunlight(v3s16 pos) const;
@@ -248,6 +252,10 @@ class ServerEnvironment final : public Environment
 	// This makes stuff happen
 	void step(f32 dtime);
 
+	// Collects Lua garbage for at most spare_us, to be called with the time
+	// left until the next server step is due
+	void stepLuaGC(s64 spare_us);
+
 	u32 getGameTime() const { return m_game_time; }
 
 	void reportMaxLagEstimate(float f) { m_max_lag_estimate = f; }
@@ -368,6 +376,8 @@ class ServerEnvironment final : public Environment
 	IntervalLimiter m_active_blocks_mgmt_interval;
 	IntervalLimiter m_active_block_modifier_interval;
 	IntervalLimiter m_active_blocks_nodemetadata_interval;
+	// Node timers of the active blocks
+	NodeTimerScheduler m_node_timer_scheduler;
 	// Whether the variables below have been read from file yet
 	bool m_meta_loaded = false;
 	// Time from the beginning of the game in seconds.
@@ -396,6 +406,7 @@ class ServerEnvironment final : public Environment
 	float m_cache_abm_interval;
 	float m_cache_nodetimer_interval;
 	float m_cache_abm_time_budget;
+	float m_cache_lua_gc_step_budget;
 
 	// peer_ids in here should be unique, except that there may be many 0s
 	std::vector<RemotePlayer*> m_players;
@@ -413,6 +424,12 @@ class ServerEnvironment final : public Environment
 	MetricCounterPtr m_step_time_counter;
 	MetricGaugePtr m_active_block_gauge;
 	MetricGaugePtr m_active_object_gauge;
+	MetricGaugePtr m_lua_memory_gauge;
+	MetricCounterPtr m_lua_gc_time_counter;
+	MetricCounterPtr m_lua_gc_cycle_counter;
+
+	// Lua memory usage at the end of the last stepLuaGC()
+	size_t m_lua_memory_last = 0;
 
 	std::unique_ptr<ServerActiveObject> createSAO(ActiveObjectType type, v3f pos,
 			const std::string &data);
@@ -96,6 +96,8 @@ ServerMap::ServerMap(const std::string &savedir, IGameDef *gamedef,
 		"minetest_map_saved_blocks", "Number of blocks saved");
 	m_loaded_blocks_gauge = mb->addGauge(
 		"minetest_map_loaded_blocks", "Number of loaded blocks");
+	m_compressed_blocks_gauge = mb->addGauge(
+		"minetest_map_compressed_blocks", "Number of loaded blocks with compressed node data");
 
 	m_map_compression_level = rangelim(g_settings->getS16("map_compression_level_disk"), -1, 9);
 
@@ -276,7 +278,7 @@ void ServerMap::finishBlockMake(BlockMakeData *data,
 
 	/*
 		Blit generated stuff to map
-		NOTE: blitBackAll adds nearly everything to changed_blocks
+		NOTE: blitBackAll adds every block that it changed to changed_blocks
 	*/
 	data->vmanip->blitBackAll(changed_blocks);
 
@@ -428,7 +430,22 @@ void ServerMap::addNodeAndUpdate(v3s16 p, MapNode n,
 		bool remove_metadata)
 {
 	Map::addNodeAndUpdate(p, n, modified_blocks, remove_metadata);
+	queueLiquidsAround(p);
+}
 
+bool ServerMap::addNodesAndUpdate(const std::vector<v3s16> &positions,
+		MapNode n, std::map<v3s16, MapBlock*> &modified_blocks,
+		bool remove_metadata)
+{
+	bool succeeded = Map::addNodesAndUpdate(positions, n, modified_blocks,
+		remove_metadata);
+	for (v3s16 p : positions)
+		queueLiquidsAround(p);
+	return succeeded;
+}
+
+void ServerMap::queueLiquidsAround(v3s16 p)
+{
 	/*
 		Add neighboring liquid nodes and this node to transform queue.
 		(it's vital for the node itself to get updated last, if it was removed.)
@@ -468,9 +485,11 @@ void ServerMap::updateVManip(v3s16 pos)
 	vm->m_is_dirty = true;
 }
 
-void ServerMap::reportMetrics(u64 save_time_us, u32 saved_blocks, u32 all_blocks)
+void ServerMap::reportMetrics(u64 save_time_us, u32 saved_blocks, u32 all_blocks,
+	u32 compressed_blocks)
 {
 	m_loaded_blocks_gauge->set(all_blocks);
+	m_compressed_blocks_gauge->set(compressed_blocks);
 	m_save_time_counter->increment(save_time_us);
 	m_save_count_counter->increment(saved_blocks);
 }
@@ -498,6 +517,7 @@ void ServerMap::save(ModifiedState save_level)
 
 	u32 block_count = 0;
 	u32 block_count_all = 0; // Number of blocks in memory
+	u32 compressed_count = 0;
 
 	// Don't do anything with sqlite unless something is really saved
 	bool save_started = false;
@@ -510,6 +530,8 @@ void ServerMap::save(ModifiedState save_level)
 
 		for (MapBlock *block : blocks) {
 			block_count_all++;
+			if (block->isCompressed())
+				compressed_count++;
 
 			if(block->getModified() >= (u32)save_level) {
 				// Lazy beginSave()
@@ -544,7 +566,8 @@ void ServerMap::save(ModifiedState save_level)
 	}
 
 	const auto end_time = porting::getTimeUs();
-	reportMetrics(end_time - start_time, block_count, block_count_all);
+	reportMetrics(end_time - start_time, block_count, block_count_all,
+		compressed_count);
 }
 
 void ServerMap::listAllLoadableBlocks(std::vector<v3s16> &dst)
@@ -882,6 +905,9 @@ void ServerMap::transformLiquids(std::map<v3s16, MapBlock*> &modified_blocks,
 	u32 liquid_loop_max = g_settings->getS32("liquid_loop_max");
 	u32 loop_max = liquid_loop_max;
 
+	// Neighbor lookups mostly hit the block of the node being processed
+	MapBlockCache blocks(this);
+
 	while (m_transforming_liquid.size() != 0)
 	{
 		// This should be done here so that it is done when continue is used
@@ -895,7 +921,7 @@ void ServerMap::transformLiquids(std::map<v3s16, MapBlock*> &modified_blocks,
 		v3s16 p0 = m_transforming_liquid.front();
 		m_transforming_liquid.pop_front();
 
-		MapNode n0 = getNode(p0);
+		MapNode n0 = blocks.getNode(p0);
 
 		/*
 			Collect information about current node
@@ -957,7 +983,7 @@ void ServerMap::transformLiquids(std::map<v3s16, MapBlock*> &modified_blocks,
 					break;
 			}
 			v3s16 npos = p0 + liquid_6dirs[i];
-			NodeNeighbor nb(getNode(npos), nt, npos);
+			NodeNeighbor nb(blocks.getNode(npos), nt, npos);
 			const ContentFeatures &cfnb = m_nodedef->get(nb.n);
 			if (nt == NEIGHBOR_UPPER && cfnb.floats)
 				floating_node_above = true;
@@ -1117,7 +1143,10 @@ void ServerMap::transformLiquids(std::map<v3s16, MapBlock*> &modified_blocks,
 
 		// on_flood() the node
 		if (floodable_node != CONTENT_AIR) {
-			if (env->getScriptIface()->node_on_flood(p0, n00, n0))
+			bool skip = env->getScriptIface()->node_on_flood(p0, n00, n0);
+			// Lua may have loaded or removed blocks
+			blocks.clear();
+			if (skip)
 				continue;
 		}
 
@@ -1149,7 +1178,7 @@ void ServerMap::transformLiquids(std::map<v3s16, MapBlock*> &modified_blocks,
 		}
 
 		v3s16 blockpos = getNodeBlockPos(p0);
-		MapBlock *block = getBlockNoCreateNoEx(blockpos);
+		MapBlock *block = blocks.getBlockNoCreateNoEx(blockpos);
 		if (block != NULL) {
 			modified_blocks[blockpos] =  block;
 			changed_nodes.emplace_back(p0, n00);
@@ -1179,6 +1208,7 @@ void ServerMap::transformLiquids(std::map<v3s16, MapBlock*> &modified_blocks,
 		}
 	}
 	//infostream<<"Map::transformLiquids(): loopcount="<<loopcount<<std::endl;
+	blocks.reportHitRate("ServerMap: liquid block cache hits [%]");
 
 	for (const auto &iter : must_reflow)
 		m_transforming_liquid.push_back(iter);
@@ -98,6 +98,9 @@ class ServerMap : public Map
 	void addNodeAndUpdate(v3s16 p, MapNode n,
 			std::map<v3s16, MapBlock*> &modified_blocks,
 			bool remove_metadata) override;
+	bool addNodesAndUpdate(const std::vector<v3s16> &positions,
+			MapNode n, std::map<v3s16, MapBlock*> &modified_blocks,
+			bool remove_metadata) override;
 
 	/*
 		Database functions
@@ -164,11 +167,15 @@ class ServerMap : public Map
 
 protected:
 
-	void reportMetrics(u64 save_time_us, u32 saved_blocks, u32 all_blocks) override;
+	void reportMetrics(u64 save_time_us, u32 saved_blocks, u32 all_blocks,
+		u32 compressed_blocks) override;
 
 private:
 	friend class ModApiMapgen; // for m_transforming_liquid
 
+	// Queues neighboring liquid nodes and p itself for transforming
+	void queueLiquidsAround(v3s16 p);
+
 	// Emerge manager
 	EmergeManager *m_emerge;
 
@@ -199,6 +206,7 @@ class ServerMap : public Map
 
 	// Map metrics
 	MetricGaugePtr m_loaded_blocks_gauge;
+	MetricGaugePtr m_compressed_blocks_gauge;
 	MetricCounterPtr m_save_time_counter;
 	MetricCounterPtr m_save_count_counter;
 };
@@ -4,6 +4,7 @@
 
 #include "test.h"
 
+#include "irr_v3d.h"
 #include "util/container.h"
 
 class TestDataStructures : public TestBase
@@ -19,6 +20,8 @@ class TestDataStructures : public TestBase
 	void testMap3();
 	void testMap4();
 	void testMap5();
+
+	void testUniqueQueue();
 };
 
 static TestDataStructures g_test_instance;
@@ -31,6 +34,9 @@ void TestDataStructures::runTests(IGameDef *gamedef)
 	TEST(testMap3);
 	TEST(testMap4);
 	TEST(testMap5);
+
+	rawstream << "-------- UniqueQueue" << std::endl;
+	TEST(testUniqueQueue);
 }
 
 namespace {
@@ -168,3 +174,29 @@ void TestDataStructures::testMap5()
 		break;
 	}
 }
+
+void TestDataStructures::testUniqueQueue()
+{
+	UniqueQueue<v3s16> queue;
+
+	// values come out in the order they were first pushed
+	UASSERT(queue.push_back(v3s16(3, 0, 0)));
+	UASSERT(queue.push_back(v3s16(-1, 2, 0)));
+	UASSERT(!queue.push_back(v3s16(3, 0, 0)));
+	UASSERT(queue.push_back(v3s16(0, 0, 7)));
+	UASSERTEQ(size_t, queue.size(), 3);
+
+	UASSERT(queue.front() == v3s16(3, 0, 0));
+	queue.pop_front();
+	// a popped value can be queued again
+	UASSERT(queue.push_back(v3s16(3, 0, 0)));
+	UASSERT(!queue.push_back(v3s16(-1, 2, 0)));
+
+	UASSERT(queue.front() == v3s16(-1, 2, 0));
+	queue.pop_front();
+	UASSERT(queue.front() == v3s16(0, 0, 7));
+	queue.pop_front();
+	UASSERT(queue.front() == v3s16(3, 0, 0));
+	queue.pop_front();
+	UASSERT(queue.empty());
+}
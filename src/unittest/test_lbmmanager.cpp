@@ -7,6 +7,9 @@
 #include <sstream>
 
 #include "server/blockmodifier.h"
+#include "mapblock.h"
+#include "gamedef.h"
+#include "nodedef.h"
 
 class TestLBMManager : public TestBase
 {
@@ -19,6 +22,7 @@ class TestLBMManager : public TestBase
 	void testNew(IGameDef *gamedef);
 	void testExisting(IGameDef *gamedef);
 	void testDiscard(IGameDef *gamedef);
+	void testApply(IGameDef *gamedef);
 };
 
 static TestLBMManager g_test_instance;
@@ -28,6 +32,7 @@ void TestLBMManager::runTests(IGameDef *gamedef)
 	TEST(testNew, gamedef);
 	TEST(testExisting, gamedef);
 	TEST(testDiscard, gamedef);
+	TEST(testApply, gamedef);
 }
 
 namespace {
@@ -38,6 +43,22 @@ namespace {
 			trigger_contents.emplace_back("air");
 		}
 	};
+
+	// Records its calls and replaces the first node it sees by stone
+	struct RecordingLBM : FakeLBM {
+		using FakeLBM::FakeLBM;
+
+		void trigger(ServerEnvironment *env, MapBlock *block,
+			const std::vector<v3s16> &positions, float dtime_s) override
+		{
+			calls.push_back(positions);
+			if (replace != CONTENT_IGNORE)
+				block->setNodeNoCheck(positions[0], MapNode(replace));
+		}
+
+		std::vector<std::vector<v3s16>> calls;
+		content_t replace = CONTENT_IGNORE;
+	};
 }
 
 void TestLBMManager::testNew(IGameDef *gamedef)
@@ -79,4 +100,47 @@ void TestLBMManager::testDiscard(IGameDef *gamedef)
 	UASSERTEQ(auto, str, "");
 }
 
-// We should also test LBMManager::applyLBMs in the future.
+void TestLBMManager::testApply(IGameDef *gamedef)
+{
+	LBMManager mgr;
+
+	auto *lbm_old = new RecordingLBM("test:old", false);
+	auto *lbm_new = new RecordingLBM("test:new", false);
+	auto *lbm_always = new RecordingLBM("test:always", true);
+	lbm_old->replace = gamedef->ndef()->getId("default:stone");
+	UASSERT(lbm_old->replace != CONTENT_IGNORE);
+	mgr.addLBMDef(lbm_old);
+	mgr.addLBMDef(lbm_new);
+	mgr.addLBMDef(lbm_always);
+	mgr.loadIntroductionTimes("test:old~10;", gamedef, 100);
+
+	MapBlock block({0, 0, 0}, gamedef);
+	block.setNodeNoCheck(1, 2, 3, MapNode(CONTENT_AIR));
+	block.setNodeNoCheck(4, 5, 6, MapNode(CONTENT_AIR));
+	block.setNodeNoCheck(15, 15, 15, MapNode(CONTENT_AIR));
+
+	// A block not seen since before all LBMs were introduced gets all of them,
+	// and later ones only see the nodes left by earlier ones
+	mgr.applyLBMs(nullptr, &block, 5, 0);
+	UASSERTEQ(size_t, lbm_old->calls.size(), 1);
+	UASSERTEQ(size_t, lbm_old->calls[0].size(), 3);
+	UASSERT(lbm_old->calls[0][0] == v3s16(1, 2, 3));
+	UASSERT(lbm_old->calls[0][2] == v3s16(15, 15, 15));
+	UASSERTEQ(size_t, lbm_new->calls.size(), 1);
+	UASSERTEQ(size_t, lbm_new->calls[0].size(), 2);
+	UASSERT(lbm_new->calls[0][0] == v3s16(4, 5, 6));
+	UASSERTEQ(size_t, lbm_always->calls.size(), 1);
+
+	// Only the newer ones
+	lbm_old->replace = CONTENT_IGNORE;
+	mgr.applyLBMs(nullptr, &block, 50, 0);
+	UASSERTEQ(size_t, lbm_old->calls.size(), 1);
+	UASSERTEQ(size_t, lbm_new->calls.size(), 2);
+	UASSERTEQ(size_t, lbm_always->calls.size(), 2);
+
+	// Only the one that always runs
+	mgr.applyLBMs(nullptr, &block, 200, 0);
+	UASSERTEQ(size_t, lbm_new->calls.size(), 2);
+	UASSERTEQ(size_t, lbm_always->calls.size(), 3);
+	UASSERTEQ(size_t, lbm_always->calls[2].size(), 2);
+}
@@ -23,6 +23,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <unordered_map>
 #include "mapblock.h"
 #include "dummymap.h"
+#include "mapblockindex.h"
+#include "noise.h"
 
 class TestMap : public TestBase
 {
@@ -36,6 +38,9 @@ class TestMap : public TestBase
 	void testForEachNodeInArea(IGameDef *gamedef);
 	void testForEachNodeInAreaBlank(IGameDef *gamedef);
 	void testForEachNodeInAreaEmpty(IGameDef *gamedef);
+	void testMapBlockCache(IGameDef *gamedef);
+	void testAddNodesAndUpdate(IGameDef *gamedef);
+	void testMapBlockIndex();
 };
 
 static TestMap g_test_instance;
@@ -46,6 +51,9 @@ void TestMap::runTests(IGameDef *gamedef)
 	TEST(testForEachNodeInArea, gamedef);
 	TEST(testForEachNodeInAreaBlank, gamedef);
 	TEST(testForEachNodeInAreaEmpty, gamedef);
+	TEST(testMapBlockCache, gamedef);
+	TEST(testAddNodesAndUpdate, gamedef);
+	TEST(testMapBlockIndex);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -169,3 +177,133 @@ void TestMap::testForEachNodeInAreaEmpty(IGameDef *gamedef)
 		return true;
 	});
 }
+
+void TestMap::testMapBlockCache(IGameDef *gamedef)
+{
+	DummyMap map(gamedef, v3s16(-2, -2, -2), v3s16(1, 1, 1));
+	map.setNode(v3s16(-17, 3, 15), MapNode(t_CONTENT_STONE));
+
+	MapBlockCache blocks(&map);
+	// Every block and its neighbors, both from the map and from the cache
+	for (s16 z = -3; z <= 2; z++)
+	for (s16 y = -3; y <= 2; y++)
+	for (s16 x = -3; x <= 2; x++) {
+		v3s16 bp(x, y, z);
+		for (int i = 0; i < 2; i++)
+			UASSERT(blocks.getBlockNoCreateNoEx(bp) == map.getBlockNoCreateNoEx(bp));
+	}
+
+	bool is_valid_position = false;
+	MapNode n = blocks.getNode(v3s16(-17, 3, 15), &is_valid_position);
+	UASSERT(is_valid_position);
+	UASSERTEQ(content_t, n.getContent(), t_CONTENT_STONE);
+
+	n = blocks.getNode(v3s16(0, 32, 0), &is_valid_position);
+	UASSERT(!is_valid_position);
+	UASSERTEQ(content_t, n.getContent(), CONTENT_IGNORE);
+
+	// Missing blocks are cached until cleared
+	map.getSectorNoGenerate(v2s16(0, 0))->createBlankBlock(2);
+	UASSERT(blocks.getBlockNoCreateNoEx(v3s16(0, 2, 0)) == nullptr);
+	blocks.clear();
+	UASSERT(blocks.getBlockNoCreateNoEx(v3s16(0, 2, 0)) != nullptr);
+}
+
+void TestMap::testAddNodesAndUpdate(IGameDef *gamedef)
+{
+	// Setting nodes in bulk must give the same result (including lighting)
+	// as setting them one by one
+	const v3s16 bpmin(-1, -1, -1), bpmax(0, 0, 0);
+	DummyMap map_single(gamedef, bpmin, bpmax);
+	DummyMap map_bulk(gamedef, bpmin, bpmax);
+	map_single.fill(bpmin, bpmax, MapNode(CONTENT_AIR));
+	map_bulk.fill(bpmin, bpmax, MapNode(CONTENT_AIR));
+
+	auto compare = [&] () {
+		v3s16 minp = bpmin * MAP_BLOCKSIZE;
+		v3s16 maxp = (bpmax + 1) * MAP_BLOCKSIZE - 1;
+		for (s16 z = minp.Z; z <= maxp.Z; z++)
+		for (s16 y = minp.Y; y <= maxp.Y; y++)
+		for (s16 x = minp.X; x <= maxp.X; x++) {
+			v3s16 p(x, y, z);
+			UASSERT(map_single.getNode(p) == map_bulk.getNode(p));
+		}
+	};
+
+	std::vector<v3s16> positions;
+	for (s16 i = -12; i <= 12; i += 4)
+		positions.emplace_back(i, -i / 2, 3);
+	positions.emplace_back(100, 0, 0); // not loaded
+
+	std::map<v3s16, MapBlock*> modified_blocks;
+	for (v3s16 p : positions) {
+		try {
+			map_single.addNodeAndUpdate(p, MapNode(t_CONTENT_TORCH), modified_blocks);
+		} catch (InvalidPositionException &e) {
+		}
+	}
+	UASSERT(!map_bulk.addNodesAndUpdate(positions, MapNode(t_CONTENT_TORCH),
+		modified_blocks));
+	UASSERTEQ(content_t, map_bulk.getNode(positions[0]).getContent(), t_CONTENT_TORCH);
+	compare();
+
+	positions.resize(3);
+	for (v3s16 p : positions)
+		map_single.removeNodeAndUpdate(p, modified_blocks);
+	UASSERT(map_bulk.addNodesAndUpdate(positions, MapNode(CONTENT_AIR),
+		modified_blocks));
+	compare();
+}
+
+void TestMap::testMapBlockIndex()
+{
+	MapBlockIndex index;
+	std::unordered_map<v3s16, MapBlock*> reference;
+	UASSERT(index.empty());
+	UASSERT(!index.get(v3s16(0, 0, 0)));
+	UASSERT(!index.remove(v3s16(0, 0, 0)));
+
+	// The index does not dereference the blocks, fake pointers are fine
+	const auto fake_block = [] (u32 i) {
+		return reinterpret_cast<MapBlock*>((uintptr_t)(i + 1) * 16);
+	};
+
+	// Add and remove random positions in a small area, so that both
+	// collisions and growing/shrinking of the table happen
+	PcgRandom pr(1234);
+	for (u32 i = 0; i < 20000; i++) {
+		v3s16 p(pr.range(-8, 8), pr.range(-8, 8), pr.range(-2000, 2000));
+		if (pr.range(0, 2) == 0) {
+			bool removed = reference.erase(p) > 0;
+			UASSERTEQ(bool, index.remove(p), removed);
+		} else {
+			index.set(p, fake_block(i));
+			reference[p] = fake_block(i);
+		}
+		if (i % 1000 == 0) {
+			for (auto &it : reference)
+				UASSERT(index.get(it.first) == it.second);
+		}
+	}
+	UASSERTEQ(size_t, index.size(), reference.size());
+	for (auto &it : reference)
+		UASSERT(index.get(it.first) == it.second);
+
+	// Extreme positions must not collide with each other
+	index.clear();
+	UASSERT(index.empty());
+	const v3s16 corners[] = {
+		v3s16(-32768, -32768, -32768), v3s16(32767, 32767, 32767),
+		v3s16(-1, -1, -1), v3s16(0, 0, 0), v3s16(-1, 0, 0),
+	};
+	for (u32 i = 0; i < ARRLEN(corners); i++)
+		index.set(corners[i], fake_block(i));
+	for (u32 i = 0; i < ARRLEN(corners); i++)
+		UASSERT(index.get(corners[i]) == fake_block(i));
+
+	// Removing everything works
+	for (const v3s16 &p : corners)
+		UASSERT(index.remove(p));
+	UASSERT(index.empty());
+	UASSERT(!index.get(v3s16(0, 0, 0)));
+}
@@ -10,6 +10,7 @@
 #include "serialization.h"
 #include "noise.h"
 #include "inventory.h"
+#include "voxel.h"
 
 class TestMapBlock : public TestBase
 {
@@ -33,6 +34,12 @@ class TestMapBlock : public TestBase
 
 	// Tests loading a non-standard MapBlock
 	void testLoadNonStd(IGameDef *gamedef);
+
+	void testVoxelManipCopy(IGameDef *gamedef);
+
+	void testCompressNodes(IGameDef *gamedef);
+
+	void testNodeTimerScheduler(IGameDef *gamedef);
 };
 
 static TestMapBlock g_test_instance;
@@ -45,6 +52,9 @@ void TestMapBlock::runTests(IGameDef *gamedef)
 	TEST(testLoad29, gamedef);
 	TEST(testLoad20, gamedef);
 	TEST(testLoadNonStd, gamedef);
+	TEST(testVoxelManipCopy, gamedef);
+	TEST(testCompressNodes, gamedef);
+	TEST(testNodeTimerScheduler, gamedef);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -68,11 +78,13 @@ void TestMapBlock::testSaveLoad(IGameDef *gamedef, const u8 version)
 		MapBlock block({}, gamedef);
 		// Fill with data
 		PcgRandom r(seed);
+		std::vector<MapNode> nodes(MapBlock::nodecount);
 		for (size_t i = 0; i < MapBlock::nodecount; ++i) {
 			u32 rval = r.next();
-			block.getData()[i] =
+			nodes[i] =
 				MapNode(rval % max, (rval >> 16) & 0xff, (rval >> 24) & 0xff);
 		}
+		block.copyNodesFrom(nodes.data());
 
 		// Serialize
 		block.serialize(ss, version, true, -1);
@@ -85,11 +97,13 @@ void TestMapBlock::testSaveLoad(IGameDef *gamedef, const u8 version)
 
 		// Check data
 		PcgRandom r(seed);
+		std::vector<MapNode> nodes(MapBlock::nodecount);
+		block.copyNodesTo(nodes.data());
 		for (size_t i = 0; i < MapBlock::nodecount; ++i) {
 			u32 rval = r.next();
 			auto expect =
 				MapNode(rval % max, (rval >> 16) & 0xff, (rval >> 24) & 0xff);
-			UASSERT(block.getData()[i] == expect);
+			UASSERT(nodes[i] == expect);
 		}
 	}
 }
@@ -104,8 +118,7 @@ void TestMapBlock::testSave29(IGameDef *gamedef)
 	{
 		// Prepare test block
 		MapBlock block({}, gamedef);
-		for (size_t i = 0; i < MapBlock::nodecount; ++i)
-			block.getData()[i] = MapNode(CONTENT_AIR);
+		block.fill(MapNode(CONTENT_AIR));
 		block.setNode({0, 0, 0}, MapNode(t_CONTENT_STONE));
 
 		block.serialize(ss, 29, true, -1);
@@ -294,8 +307,9 @@ void TestMapBlock::testLoad20(IGameDef *gamedef)
 	UASSERTEQ(auto, get_node(10, 6, 4), "air");
 	UASSERTEQ(auto, get_node(11, 6, 3), "default:furnace");
 
+	const content_t *contents = block.getContentData();
 	for (size_t i = 0; i < MapBlock::nodecount; ++i)
-		UASSERT(block.getData()[i].getContent() != CONTENT_IGNORE);
+		UASSERT(contents[i] != CONTENT_IGNORE);
 
 	// metadata is also translated
 	auto *meta = block.m_node_metadata.get({11, 6, 3});
@@ -356,3 +370,171 @@ void TestMapBlock::testLoadNonStd(IGameDef *gamedef)
 	for (s16 i = 0; i < 16; i++)
 		UASSERTEQ(int, block.getNodeNoEx({i, 1, 0}).param2, data_lo[i]);
 }
+
+void TestMapBlock::testVoxelManipCopy(IGameDef *gamedef)
+{
+	MapBlock block({1, -1, 0}, gamedef);
+	const v3s16 pos = block.getPosRelative();
+	PcgRandom r(1234);
+	for (s16 z = 0; z < MAP_BLOCKSIZE; z++)
+	for (s16 y = 0; y < MAP_BLOCKSIZE; y++)
+	for (s16 x = 0; x < MAP_BLOCKSIZE; x++)
+		block.setNodeNoCheck(x, y, z, MapNode(r.range(0, 100), r.next() & 0xff, x));
+
+	// The VoxelManipulator is larger than the block
+	VoxelManipulator vm;
+	vm.addArea(VoxelArea(pos - 2, pos + MAP_BLOCKSIZE + 1));
+	block.copyTo(vm);
+	for (s16 z = 0; z < MAP_BLOCKSIZE; z++)
+	for (s16 y = 0; y < MAP_BLOCKSIZE; y++)
+	for (s16 x = 0; x < MAP_BLOCKSIZE; x++) {
+		const v3s16 p(x, y, z);
+		UASSERT(vm.getNodeRefUnsafe(pos + p) == block.getNodeNoCheck(p));
+		UASSERT(!(vm.getFlagsRefUnsafe(pos + p) & VOXELFLAG_NO_DATA));
+	}
+	UASSERT(vm.getFlagsRefUnsafe(pos - 1) & VOXELFLAG_NO_DATA);
+
+	// CONTENT_IGNORE is not copied back
+	const v3s16 p_air(3, 4, 5), p_ignore(5, 4, 3);
+	const MapNode n_before = block.getNodeNoCheck(p_ignore);
+	vm.setNode(pos + p_air, MapNode(CONTENT_AIR, 0, 7));
+	vm.setNode(pos + p_ignore, MapNode(CONTENT_IGNORE));
+	block.copyFrom(vm);
+	UASSERT(block.getNodeNoCheck(p_air) == MapNode(CONTENT_AIR, 0, 7));
+	UASSERT(block.getNodeNoCheck(p_ignore) == n_before);
+	UASSERTEQ(content_t, block.getContentData()[
+		p_air.Z * MapBlock::zstride + p_air.Y * MapBlock::ystride + p_air.X],
+		CONTENT_AIR);
+	UASSERTEQ(int, block.getParam2Data()[
+		p_air.Z * MapBlock::zstride + p_air.Y * MapBlock::ystride + p_air.X], 7);
+}
+
+void TestMapBlock::testCompressNodes(IGameDef *gamedef)
+{
+	// Single node
+	{
+		MapBlock block({}, gamedef);
+		block.fill(MapNode(t_CONTENT_STONE));
+		UASSERT(block.compressNodes());
+		UASSERT(block.isCompressed());
+		UASSERT(block.getNodeNoCheck(5, 6, 7) == MapNode(t_CONTENT_STONE));
+		UASSERT(!block.isAir());
+	}
+
+	// A few distinct nodes, reads don't decompress and writes do
+	{
+		MapBlock block({}, gamedef);
+		std::vector<MapNode> nodes(MapBlock::nodecount);
+		PcgRandom r(42);
+		for (auto &n : nodes)
+			n = MapNode(r.range(0, 2), r.range(0, 1), r.range(0, 1));
+		block.copyNodesFrom(nodes.data());
+
+		std::stringstream expect;
+		block.serialize(expect, SER_FMT_VER_HIGHEST_WRITE, true, -1);
+
+		UASSERT(block.compressNodes());
+		std::vector<MapNode> nodes2(MapBlock::nodecount);
+		block.copyNodesTo(nodes2.data());
+		UASSERT(nodes2 == nodes);
+		std::stringstream ss;
+		block.serialize(ss, SER_FMT_VER_HIGHEST_WRITE, true, -1);
+		UASSERT(ss.str() == expect.str());
+		UASSERT(block.isCompressed());
+
+		block.setNodeNoCheck(1, 2, 3, MapNode(CONTENT_AIR, 0, 99));
+		UASSERT(!block.isCompressed());
+		nodes[3 * MapBlock::zstride + 2 * MapBlock::ystride + 1] =
+			MapNode(CONTENT_AIR, 0, 99);
+		block.copyNodesTo(nodes2.data());
+		UASSERT(nodes2 == nodes);
+	}
+
+	// Too many distinct nodes
+	{
+		MapBlock block({}, gamedef);
+		for (s16 x = 0; x < MAP_BLOCKSIZE; x++)
+			block.setNodeNoCheck(x, 0, 0, MapNode(CONTENT_AIR, x));
+		UASSERT(!block.compressNodes());
+		UASSERT(!block.isCompressed());
+	}
+}
+
+void TestMapBlock::testNodeTimerScheduler(IGameDef *gamedef)
+{
+	NodeTimerScheduler scheduler;
+	MapBlock block_a({0, 0, 0}, gamedef), block_b({1, 0, 0}, gamedef);
+	block_a.setNodeTimer(NodeTimer(1.0f, 0.0f, {1, 2, 3}));
+	block_b.setNodeTimer(NodeTimer(3.0f, 0.0f, {4, 5, 6}));
+
+	std::vector<std::pair<v3s16, f32>> called;
+	auto on_timer = [&](v3s16 p, MapNode n, f32 elapsed) -> bool {
+		called.emplace_back(p, elapsed);
+		return false;
+	};
+
+	// Time passes while the block is not active
+	block_a.step(0.5f, on_timer);
+	UASSERT(called.empty());
+
+	block_a.attachNodeTimers(&scheduler);
+	block_b.attachNodeTimers(&scheduler);
+	UASSERT(block_a.nodeTimersAttached());
+	UASSERTEQ(size_t, scheduler.step(0.25f).size(), 0);
+	UASSERT(std::abs(block_a.getNodeTimer({1, 2, 3}).elapsed - 0.75f) < 0.001f);
+	UASSERT(std::abs(block_b.getNodeTimer({4, 5, 6}).elapsed - 0.25f) < 0.001f);
+
+	// Only the block with a due timer comes up
+	auto due = scheduler.step(0.5f);
+	UASSERTEQ(size_t, due.size(), 1);
+	UASSERT(due[0] == v3s16(0, 0, 0));
+	block_a.runDueNodeTimers(on_timer);
+	UASSERTEQ(size_t, called.size(), 1);
+	UASSERT(called[0].first == v3s16(1, 2, 3));
+	UASSERT(std::abs(called[0].second - 1.25f) < 0.001f);
+	UASSERT(block_a.getNodeTimer({1, 2, 3}).timeout == 0.0f);
+
+	// A timer set while attached gets scheduled
+	block_a.setNodeTimer(NodeTimer(0.5f, 0.0f, {1, 1, 1}));
+	due = scheduler.step(0.5f);
+	UASSERTEQ(size_t, due.size(), 1);
+	block_a.runDueNodeTimers(on_timer);
+	UASSERTEQ(size_t, called.size(), 2);
+
+	// Removing the earliest timer must not lose the later one
+	block_b.setNodeTimer(NodeTimer(0.5f, 0.0f, {7, 7, 7}));
+	block_b.removeNodeTimer({7, 7, 7});
+	due = scheduler.step(1.0f);
+	UASSERTEQ(size_t, due.size(), 1);
+	block_b.runDueNodeTimers(on_timer);
+	UASSERTEQ(size_t, called.size(), 2);
+	due = scheduler.step(1.0f);
+	UASSERTEQ(size_t, due.size(), 1);
+	UASSERT(due[0] == v3s16(1, 0, 0));
+	block_b.runDueNodeTimers(on_timer);
+	UASSERTEQ(size_t, called.size(), 3);
+	UASSERT(called[2].first == v3s16(4 + MAP_BLOCKSIZE, 5, 6));
+
+	// Restarting a timer again and again doesn't pile up entries
+	const size_t queued = scheduler.size();
+	for (int i = 0; i < 100; i++)
+		block_a.setNodeTimer(NodeTimer(1.0f + i * 0.01f, 0.0f, {2, 2, 2}));
+	UASSERT(scheduler.size() <= queued + 1);
+	due = scheduler.step(1.5f);
+	UASSERTEQ(size_t, due.size(), 1);
+	block_a.runDueNodeTimers(on_timer);
+	UASSERTEQ(size_t, called.size(), 3);
+	due = scheduler.step(0.5f);
+	UASSERTEQ(size_t, due.size(), 1);
+	block_a.runDueNodeTimers(on_timer);
+	UASSERTEQ(size_t, called.size(), 4);
+	UASSERT(called[3].first == v3s16(2, 2, 2));
+
+	// The time of a detached block stands still
+	block_a.setNodeTimer(NodeTimer(2.0f, 0.0f, {1, 1, 1}));
+	scheduler.step(1.0f);
+	block_a.detachNodeTimers();
+	UASSERT(!block_a.nodeTimersAttached());
+	scheduler.step(5.0f);
+	UASSERT(std::abs(block_a.getNodeTimer({1, 1, 1}).elapsed - 1.0f) < 0.001f);
+}
@@ -4,10 +4,14 @@
 
 #include "test.h"
 
+#include "dummymap.h"
 #include "emerge.h"
 #include "mapgen/mapgen.h"
 #include "mapgen/mg_biome.h"
+#include "mapgen/mg_decoration.h"
+#include "mapgen/mg_ore.h"
 #include "mock_server.h"
+#include "noise.h"
 
 class TestMapgen : public TestBase
 {
@@ -18,6 +22,8 @@ class TestMapgen : public TestBase
 	void runTests(IGameDef *gamedef);
 
 	void testBiomeGen(IGameDef *gamedef);
+	void testOreVein(IGameDef *gamedef, const NodeDefManager *ndef);
+	void testPlaceAllDecos(IGameDef *gamedef, const NodeDefManager *ndef);
 };
 
 static TestMapgen g_test_instance;
@@ -36,7 +42,16 @@ namespace {
 
 void TestMapgen::runTests(IGameDef *gamedef)
 {
+	NodeDefManager *ndef =
+		(NodeDefManager *)gamedef->getNodeDefManager();
+
+	ndef->setNodeRegistrationStatus(true);
+
 	TEST(testBiomeGen, gamedef);
+	TEST(testOreVein, gamedef, ndef);
+	TEST(testPlaceAllDecos, gamedef, ndef);
+
+	ndef->resetNodeResolveState();
 }
 
 void TestMapgen::testBiomeGen(IGameDef *gamedef)
@@ -123,3 +138,194 @@ void TestMapgen::testBiomeGen(IGameDef *gamedef)
 	}
 }
 
+
+namespace {
+
+// OreVein::generate as it was before the wherein and biome lookup tables
+void reference_vein(const OreVein &ore, MMVManip *vm, int mapseed,
+	u32 blockseed, v3s16 nmin, v3s16 nmax, const biome_t *biomemap)
+{
+	PcgRandom pr(blockseed + 520);
+	MapNode n_ore(ore.c_ore, 0, ore.ore_param2);
+
+	int sizex = nmax.X - nmin.X + 1;
+	int sizey = nmax.Y - nmin.Y + 1;
+	int sizez = nmax.Z - nmin.Z + 1;
+	Noise noise(&ore.np, mapseed, sizex, sizey, sizez);
+	Noise noise2(&ore.np, mapseed + 436, sizex, sizey, sizez);
+	noise.noiseMap3D(nmin.X, nmin.Y, nmin.Z);
+	noise2.noiseMap3D(nmin.X, nmin.Y, nmin.Z);
+
+	size_t index = 0;
+	for (int z = nmin.Z; z <= nmax.Z; z++)
+	for (int y = nmin.Y; y <= nmax.Y; y++)
+	for (int x = nmin.X; x <= nmax.X; x++, index++) {
+		u32 i = vm->m_area.index(x, y, z);
+		if (!vm->m_area.contains(i))
+			continue;
+		if (!CONTAINS(ore.c_wherein, vm->m_data[i].getContent()))
+			continue;
+
+		if (biomemap && !ore.biomes.empty()) {
+			u32 bmapidx = sizex * (z - nmin.Z) + (x - nmin.X);
+			auto it = ore.biomes.find(biomemap[bmapidx]);
+			if (it == ore.biomes.end())
+				continue;
+		}
+
+		float randval   = (float)pr.next() / float(pr.RANDOM_RANGE / 2) - 1.f;
+		float noiseval  = contour(noise.result[index]);
+		float noiseval2 = contour(noise2.result[index]);
+		if (noiseval * noiseval2 + randval * ore.random_factor < ore.nthresh)
+			continue;
+
+		vm->m_data[i] = n_ore;
+	}
+}
+
+}
+
+void TestMapgen::testOreVein(IGameDef *gamedef, const NodeDefManager *ndef)
+{
+	const v3s16 nmin(-20, -30, -20), nmax(19, 9, 19);
+	const s16 sizex = nmax.X - nmin.X + 1, sizez = nmax.Z - nmin.Z + 1;
+	DummyMap map(gamedef, v3s16(0, 0, 0), v3s16(-1, -1, -1));
+	MMVManip vm(&map);
+	vm.addArea(VoxelArea(nmin - v3s16(1), nmax + v3s16(1)));
+	const u32 volume = vm.m_area.getVolume();
+
+	OreVein ore;
+	ore.m_nodenames = {"default:lava", "default:stone", "default:brick"};
+	ore.m_nnlistsizes = {2};
+	ndef->pendNodeResolve(&ore);
+	UASSERTEQ(size_t, ore.c_wherein.size(), 2);
+	ore.ore_param2 = 0;
+	ore.nthresh = 0.2f;
+	ore.random_factor = 0.5f;
+	ore.np = NoiseParams(0, 1, v3f(20, 20, 20), 12345, 3, 0.5, 2.0);
+
+	const content_t contents[] = {CONTENT_AIR, t_CONTENT_STONE,
+		t_CONTENT_BRICK, t_CONTENT_WATER};
+	std::vector<biome_t> biomemap(sizex * sizez);
+	PcgRandom pr(4321);
+	for (int round = 0; round < 4; round++) {
+		for (u32 i = 0; i < volume; i++)
+			vm.m_data[i] = MapNode(contents[pr.range(0, ARRLEN(contents) - 1)]);
+		for (biome_t &biome : biomemap)
+			biome = pr.range(0, 1);
+
+		// Any biome, one of the chunk, none of the chunk, no biomemap
+		ore.biomes.clear();
+		if (round == 1)
+			ore.biomes.insert(1);
+		else if (round == 2)
+			ore.biomes.insert(3);
+		biome_t *bmap = round == 3 ? nullptr : biomemap.data();
+
+		const u32 blockseed = pr.next();
+		std::vector<MapNode> before(vm.m_data, vm.m_data + volume);
+		ore.generate(&vm, 1, blockseed, nmin, nmax, bmap);
+		std::vector<MapNode> placed(vm.m_data, vm.m_data + volume);
+		std::copy(before.begin(), before.end(), vm.m_data);
+		reference_vein(ore, &vm, 1, blockseed, nmin, nmax, bmap);
+
+		u32 nore = 0;
+		for (u32 i = 0; i < volume; i++) {
+			UASSERT(placed[i] == vm.m_data[i]);
+			if (placed[i].getContent() != before[i].getContent())
+				nore++;
+		}
+		UASSERTEQ(bool, nore > 0, round != 2);
+	}
+}
+
+void TestMapgen::testPlaceAllDecos(IGameDef *gamedef, const NodeDefManager *ndef)
+{
+	const v3s16 nmin(0, 0, 0), nmax(39, 39, 39);
+	const s16 csize = nmax.X - nmin.X + 1;
+	DummyMap map(gamedef, v3s16(0, 0, 0), v3s16(-1, -1, -1));
+	MMVManip vm(&map);
+	vm.addArea(VoxelArea(nmin - v3s16(16), nmax + v3s16(16)));
+	const u32 volume = vm.m_area.getVolume();
+
+	std::vector<s16> heightmap(csize * csize);
+	std::vector<biome_t> biomemap(csize * csize);
+	Mapgen mg;
+	mg.vm = &vm;
+	mg.ndef = ndef;
+	mg.heightmap = heightmap.data();
+
+	DecorationManager decomgr(gamedef);
+	auto add_deco = [&] (const char *place_on, const char *node,
+			std::unordered_set<biome_t> biomes, u32 flags, s16 place_offset_y,
+			s16 height) {
+		DecoSimple *deco = (DecoSimple *)DecorationManager::create(DECO_SIMPLE);
+		deco->flags = flags;
+		deco->y_min = -100;
+		deco->y_max = 100;
+		deco->sidelen = 8;
+		deco->fill_ratio = 0.2f;
+		deco->nspawnby = -1;
+		deco->place_offset_y = place_offset_y;
+		deco->biomes = std::move(biomes);
+		deco->deco_height = height;
+		deco->deco_height_max = 0;
+		deco->deco_param2 = 0;
+		deco->deco_param2_max = 0;
+		deco->m_nodenames = {place_on, node};
+		deco->m_nnlistsizes = {1, 0, 1};
+		UASSERT(decomgr.add(deco) != OBJDEF_INVALID_HANDLE);
+		ndef->pendNodeResolve(deco);
+	};
+	add_deco("default:dirt_with_grass", "default:torch", {1}, 0, 0, 2);
+	// Biome 2 doesn't occur, water is never the surface
+	add_deco("default:dirt_with_grass", "default:torch", {2}, 0, 0, 2);
+	add_deco("default:water", "default:torch", {}, 0, 0, 2);
+	// Turns stone surfaces into brick, which the next one is placed on
+	add_deco("default:stone", "default:brick", {}, DECO_FORCE_PLACEMENT, -1, 1);
+	add_deco("default:brick", "default:lava", {0}, 0, 0, 1);
+	add_deco("default:stone", "default:torch", {}, DECO_ALL_FLOORS, 0, 1);
+
+	PcgRandom pr(5678);
+	for (int round = 0; round < 3; round++) {
+		mg.biomemap = round == 2 ? nullptr : biomemap.data();
+
+		// Columns of stone topped with grass or stone, with some caves
+		size_t index = 0;
+		for (s16 z = nmin.Z; z <= nmax.Z; z++)
+		for (s16 x = nmin.X; x <= nmax.X; x++, index++) {
+			s16 height = pr.range(nmin.Y - 4, nmax.Y + 4);
+			content_t c_top = pr.range(0, 1) ? t_CONTENT_GRASS : t_CONTENT_STONE;
+			heightmap[index] = height;
+			biomemap[index] = pr.range(0, 1);
+			for (s16 y = vm.m_area.MinEdge.Y; y <= vm.m_area.MaxEdge.Y; y++) {
+				content_t c = CONTENT_AIR;
+				if (y == height)
+					c = c_top;
+				else if (y < height && (y + 30) % 10 != 5)
+					c = t_CONTENT_STONE;
+				vm.m_data[vm.m_area.index(x, y, z)] = MapNode(c);
+			}
+		}
+
+		const u32 blockseed = pr.next();
+		std::vector<MapNode> before(vm.m_data, vm.m_data + volume);
+		decomgr.placeAllDecos(&mg, blockseed, nmin, nmax);
+		std::vector<MapNode> placed(vm.m_data, vm.m_data + volume);
+
+		// Without the surface index, every decoration runs
+		std::copy(before.begin(), before.end(), vm.m_data);
+		for (size_t i = 0; i < decomgr.getNumObjects(); i++) {
+			Decoration *deco = (Decoration *)decomgr.getRaw(i);
+			deco->placeDeco(&mg, blockseed + i, nmin, nmax);
+		}
+
+		u32 nlava = 0;
+		for (u32 i = 0; i < volume; i++) {
+			UASSERT(placed[i] == vm.m_data[i]);
+			if (placed[i].getContent() == t_CONTENT_LAVA)
+				nlava++;
+		}
+		UASSERT(nlava > 0);
+	}
+}
@@ -26,6 +26,7 @@ class TestSAO : public TestBase
 	void testActivate(ServerEnvironment *env);
 	void testStaticToFalse(ServerEnvironment *env);
 	void testStaticToTrue(ServerEnvironment *env);
+	void testMovement(ServerEnvironment *env);
 
 private:
 	// enough for both removeRemovedObjects and deactivateFarObjects to be called
@@ -42,6 +43,19 @@ core.register_entity(":test:non_static", {
 		static_save = false,
 	}
 })
+-- counts the calls of on_step in its HP
+core.register_entity(":test:mover", {
+	initial_properties = {
+		static_save = false,
+		hp_max = 1000,
+	},
+	on_activate = function(self)
+		self.object:set_hp(1)
+	end,
+	on_step = function(self)
+		self.object:set_hp(self.object:get_hp() + 1)
+	end,
+})
 )";
 
 void TestSAO::runTests(IGameDef *gamedef)
@@ -85,6 +99,7 @@ void TestSAO::runTests(IGameDef *gamedef)
 	TEST(testActivate, &env);
 	TEST(testStaticToFalse, &env);
 	TEST(testStaticToTrue, &env);
+	TEST(testMovement, &env);
 
 	env.deactivateBlocksAndObjects();
 }
@@ -298,3 +313,49 @@ void TestSAO::testStaticToTrue(ServerEnvironment *env)
 	UASSERTEQ(size_t, block->m_static_objects.getStoredSize(), 1);
 	UASSERTEQ(size_t, block->m_static_objects.getActiveSize(), 0);
 }
+
+void TestSAO::testMovement(ServerEnvironment *env)
+{
+	const v3f testpos(0, 4 * BS, 10 * BS);
+
+	auto obj = add_entity(env, testpos, "test:mover");
+	UASSERT(obj);
+	UASSERTEQ(u16, obj->getHP(), 1);
+
+	EntityMovement movement;
+	movement.target = testpos + v3f(2 * BS, 0, 0);
+	movement.speed = 1 * BS;
+	movement.on_step_interval = 10.0f;
+	obj->setMovement(movement);
+
+	// Walks towards the target without calling on_step
+	for (int i = 0; i < 10; i++)
+		obj->step(0.1f, false);
+	UASSERTEQ(u16, obj->getHP(), 1);
+	v3f pos = obj->getBasePosition();
+	UASSERT(std::fabs(pos.X - 1 * BS) < 0.01f * BS);
+	UASSERTEQ(f32, pos.Y, testpos.Y);
+	UASSERTEQ(f32, pos.Z, testpos.Z);
+
+	// Reaching the target calls on_step right away
+	for (int i = 0; i < 10; i++)
+		obj->step(0.1f, false);
+	UASSERTEQ(u16, obj->getHP(), 2);
+	UASSERT(!obj->getMovement()->target);
+	pos = obj->getBasePosition();
+	UASSERT(pos.X > 1.4f * BS && pos.X < 1.6f * BS);
+	UASSERTEQ(f32, obj->getVelocity().X, 0);
+
+	// Gravity, with on_step on every step
+	movement = EntityMovement();
+	movement.gravity = 10 * BS;
+	obj->setMovement(movement);
+	obj->step(0.1f, false);
+	UASSERTEQ(u16, obj->getHP(), 3);
+	UASSERT(std::fabs(obj->getVelocity().Y + 1 * BS) < 0.01f * BS);
+	UASSERTEQ(f32, obj->getAcceleration().Y, -10 * BS);
+
+	obj->setMovement(std::nullopt);
+	obj->markForRemoval();
+	env->step(m_step_interval);
+}
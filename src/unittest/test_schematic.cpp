@@ -6,6 +6,7 @@
 
 #include "mapgen/mg_schematic.h"
 #include "gamedef.h"
+#include "dummymap.h"
 #include "nodedef.h"
 
 class TestSchematic : public TestBase {
@@ -18,6 +19,7 @@ class TestSchematic : public TestBase {
 	void testMtsSerializeDeserialize(const NodeDefManager *ndef);
 	void testLuaTableSerialize(const NodeDefManager *ndef);
 	void testFileSerializeDeserialize(const NodeDefManager *ndef);
+	void testBlitToVManip(IGameDef *gamedef, const NodeDefManager *ndef);
 
 	static const content_t test_schem1_data[7 * 6 * 4];
 	static const content_t test_schem2_data[3 * 3 * 3];
@@ -37,6 +39,7 @@ void TestSchematic::runTests(IGameDef *gamedef)
 	TEST(testMtsSerializeDeserialize, ndef);
 	TEST(testLuaTableSerialize, ndef);
 	TEST(testFileSerializeDeserialize, ndef);
+	TEST(testBlitToVManip, gamedef, ndef);
 
 	ndef->resetNodeResolveState();
 }
@@ -172,6 +175,71 @@ void TestSchematic::testFileSerializeDeserialize(const NodeDefManager *ndef)
 }
 
 
+void TestSchematic::testBlitToVManip(IGameDef *gamedef, const NodeDefManager *ndef)
+{
+	static const v3s16 size(3, 1, 2);
+	static const u32 volume = size.X * size.Y * size.Z;
+
+	Schematic schem;
+	schem.size        = size;
+	schem.schemdata   = new MapNode[volume];
+	schem.slice_probs = new u8[size.Y];
+	schem.slice_probs[0] = MTSCHEM_PROB_ALWAYS;
+	schem.m_ndef = ndef;
+	schem.m_resolve_done = true;
+
+	// Z=0
+	schem.schemdata[0] = MapNode(t_CONTENT_STONE, MTSCHEM_PROB_ALWAYS, 0);
+	schem.schemdata[1] = MapNode(t_CONTENT_GRASS, MTSCHEM_PROB_ALWAYS, 0);
+	schem.schemdata[2] = MapNode(t_CONTENT_BRICK, MTSCHEM_PROB_NEVER, 0);
+	// Z=1
+	schem.schemdata[3] = MapNode(t_CONTENT_WATER,
+		MTSCHEM_PROB_ALWAYS | MTSCHEM_FORCE_PLACE, 0);
+	schem.schemdata[4] = MapNode(CONTENT_IGNORE, MTSCHEM_PROB_ALWAYS, 0);
+	schem.schemdata[5] = MapNode(t_CONTENT_BRICK, MTSCHEM_PROB_ALWAYS, 0);
+
+	DummyMap map(gamedef, v3s16(0, 0, 0), v3s16(-1, -1, -1));
+	MMVManip vm(&map);
+	auto reset_vm = [&] () {
+		vm.clear();
+		vm.addArea(VoxelArea(v3s16(0, 0, 0), v3s16(3, 0, 3)));
+		for (u32 i = 0; i != vm.m_area.getVolume(); i++)
+			vm.m_data[i] = MapNode(CONTENT_AIR);
+		vm.m_data[vm.m_area.index(0, 0, 1)] = MapNode(t_CONTENT_LAVA);
+		vm.m_data[vm.m_area.index(2, 0, 1)] = MapNode(t_CONTENT_LAVA);
+	};
+	auto get = [&] (s16 x, s16 z) {
+		return vm.m_data[vm.m_area.index(x, 0, z)].getContent();
+	};
+
+	reset_vm();
+	schem.blitToVManip(&vm, v3s16(0, 0, 0), ROTATE_0, false);
+	UASSERTEQ(content_t, get(0, 0), t_CONTENT_STONE);
+	UASSERTEQ(content_t, get(1, 0), t_CONTENT_GRASS);
+	UASSERTEQ(content_t, get(2, 0), CONTENT_AIR);
+	UASSERTEQ(content_t, get(0, 1), t_CONTENT_WATER); // forced
+	UASSERTEQ(content_t, get(1, 1), CONTENT_AIR);
+	UASSERTEQ(content_t, get(2, 1), t_CONTENT_LAVA);  // occupied
+
+	reset_vm();
+	schem.blitToVManip(&vm, v3s16(0, 0, 0), ROTATE_90, false);
+	UASSERTEQ(content_t, get(0, 0), CONTENT_AIR);
+	UASSERTEQ(content_t, get(1, 0), t_CONTENT_BRICK);
+	UASSERTEQ(content_t, get(0, 1), t_CONTENT_LAVA);  // occupied
+	UASSERTEQ(content_t, get(1, 1), CONTENT_AIR);
+	UASSERTEQ(content_t, get(0, 2), t_CONTENT_STONE);
+	UASSERTEQ(content_t, get(1, 2), t_CONTENT_WATER);
+
+	// Partially outside of the VoxelManip
+	reset_vm();
+	schem.blitToVManip(&vm, v3s16(2, 0, 2), ROTATE_0, true);
+	UASSERTEQ(content_t, get(2, 2), t_CONTENT_STONE);
+	UASSERTEQ(content_t, get(3, 2), t_CONTENT_GRASS);
+	UASSERTEQ(content_t, get(2, 3), t_CONTENT_WATER);
+	UASSERTEQ(content_t, get(3, 3), CONTENT_AIR);
+}
+
+
 // Should form a cross-shaped-thing...?
 const content_t TestSchematic::test_schem1_data[7 * 6 * 4] = {
 	3, 3, 1, 1, 1, 3, 3, // Y=0, Z=0
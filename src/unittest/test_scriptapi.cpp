@@ -9,8 +9,15 @@
 #include "script/lua_api/l_util.h"
 #include "script/lua_api/l_settings.h"
 #include "script/common/c_converter.h"
+#include "script/common/c_packer.h"
 #include "irrlicht_changes/printing.h"
 #include "server.h"
+#include "porting.h"
+#include <map>
+
+extern "C" {
+#include <lualib.h>
+}
 
 namespace {
 	class MyScriptApi : virtual public ScriptApiBase {
@@ -19,6 +26,37 @@ namespace {
 		void init();
 		using ScriptApiBase::getStack;
 	};
+
+	class RecordingCounter : public MetricCounter {
+	public:
+		void increment(double number) override { m_value += number; }
+		double get() const override { return m_value; }
+	private:
+		double m_value = 0;
+	};
+
+	// Keeps the counters by "name mod callback" so that they can be checked
+	class RecordingMetricsBackend : public MetricsBackend {
+	public:
+		MetricCounterPtr addCounter(const std::string &name,
+				const std::string &help_str, Labels labels) override
+		{
+			std::string key = name;
+			for (auto &label : labels)
+				key.append(" ").append(label.second);
+			auto counter = std::make_shared<RecordingCounter>();
+			counters[key] = counter;
+			return counter;
+		}
+
+		double get(const std::string &key) const
+		{
+			auto it = counters.find(key);
+			return it == counters.end() ? -1 : it->second->get();
+		}
+
+		std::map<std::string, MetricCounterPtr> counters;
+	};
 }
 
 class TestScriptApi : public TestBase
@@ -33,6 +71,8 @@ class TestScriptApi : public TestBase
 	void testVectorRead(MyScriptApi *script);
 	void testVectorReadErr(MyScriptApi *script);
 	void testVectorReadMix(MyScriptApi *script);
+	void testProfiler();
+	void testPackBorrowing();
 };
 
 static TestScriptApi g_test_instance;
@@ -73,6 +113,8 @@ void TestScriptApi::runTests(IGameDef *gamedef)
 	TEST(testVectorRead, &script);
 	TEST(testVectorReadErr, &script);
 	TEST(testVectorReadMix, &script);
+	TEST(testProfiler);
+	TEST(testPackBorrowing);
 }
 
 // Runs Lua code and leaves `nresults` return values on the stack
@@ -194,3 +236,122 @@ void TestScriptApi::testVectorReadMix(MyScriptApi *script)
 		lua_pop(L, 1);
 	}
 }
+
+void TestScriptApi::testProfiler()
+{
+	ScriptProfiler profiler;
+	// Does nothing until enabled
+	UASSERT(!profiler.enter("outer"));
+
+	RecordingMetricsBackend mb;
+	profiler.enable(&mb);
+
+	{
+		ScriptProfiler::Scope outer(profiler, "outer");
+		profiler.setOrigin("mod_a");
+		{
+			ScriptProfiler::Scope inner(profiler, "inner");
+			profiler.setOrigin("mod_b");
+			porting::preciseSleepUs(2000);
+		}
+		profiler.setOrigin("mod_a");
+	}
+	{
+		// Never claimed by a mod
+		ScriptProfiler::Scope outer(profiler, "outer");
+	}
+
+	// Nothing is reported before flushing
+	UASSERTEQ(double, mb.get("minetest_script_callback_calls mod_b inner"), 0);
+	profiler.flush();
+
+	// Returning to the outer call's origin doesn't count as another call
+	UASSERTEQ(double, mb.get("minetest_script_callback_calls mod_a outer"), 1);
+	UASSERTEQ(double, mb.get("minetest_script_callback_calls mod_b inner"), 1);
+	UASSERTEQ(double, mb.get("minetest_script_callback_calls " BUILTIN_MOD_NAME " outer"), 1);
+	UASSERTEQ(double, mb.get("minetest_script_callback_calls mod_b outer"), -1);
+
+	// The time of the inner call is not counted for the outer one
+	const double inner_us = mb.get("minetest_script_callback_time mod_b inner");
+	UASSERT(inner_us >= 2000);
+	UASSERT(mb.get("minetest_script_callback_time mod_a outer") < inner_us);
+
+	// Flushing again adds nothing
+	profiler.flush();
+	UASSERTEQ(double, mb.get("minetest_script_callback_calls mod_a outer"), 1);
+
+	// Callbacks of different mods run from one call are counted per mod
+	{
+		ScriptProfiler::Scope outer(profiler, "outer");
+		profiler.setOrigin("mod_a");
+		profiler.setOrigin("mod_b");
+		profiler.setOrigin("mod_a");
+	}
+	profiler.flush();
+	UASSERTEQ(double, mb.get("minetest_script_callback_calls mod_a outer"), 3);
+	UASSERTEQ(double, mb.get("minetest_script_callback_calls mod_b outer"), 1);
+
+	// The number of mod labels is limited, three are in use already
+	const std::string other_key = std::string("minetest_script_callback_calls ") +
+		ScriptProfiler::OTHER_MOD_LABEL + " outer";
+	{
+		ScriptProfiler::Scope outer(profiler, "outer");
+		for (size_t i = 0; i < ScriptProfiler::MAX_MOD_LABELS; i++)
+			profiler.setOrigin("mod_" + std::to_string(i));
+	}
+	profiler.flush();
+	UASSERTEQ(double, mb.get("minetest_script_callback_calls mod_0 outer"), 1);
+	UASSERTEQ(double, mb.get("minetest_script_callback_calls mod_1020 outer"), 1);
+	UASSERTEQ(double, mb.get("minetest_script_callback_calls mod_1021 outer"), -1);
+	UASSERTEQ(double, mb.get(other_key), 1);
+	{
+		ScriptProfiler::Scope outer(profiler, "outer");
+		profiler.setOrigin("too_many");
+	}
+	profiler.flush();
+	UASSERTEQ(double, mb.get("minetest_script_callback_calls too_many outer"), -1);
+	UASSERTEQ(double, mb.get(other_key), 2);
+}
+
+void TestScriptApi::testPackBorrowing()
+{
+	lua_State *from = luaL_newstate();
+	lua_State *to = luaL_newstate();
+	luaL_openlibs(from);
+
+	// The big string appears three times, the small one isn't borrowed
+	run(from, "local big = string.rep('x', 100000) "
+		"return {big, big, small = 'abc', [big] = 1}", 1);
+	lua_rawgeti(from, -1, 1);
+	const char *big = lua_tostring(from, -1);
+	lua_pop(from, 1);
+
+	std::unique_ptr<PackedValue> pv(script_pack_borrowing(from, -1));
+	lua_pop(from, 1);
+	UASSERTEQ(size_t, pv->borrowed.size(), 1);
+	UASSERT(pv->borrowed[0].data == big);
+
+	// Still referenced, so it survives this
+	lua_gc(from, LUA_GCCOLLECT, 0);
+
+	script_unpack(to, pv.get());
+	lua_rawgeti(to, -1, 2);
+	UASSERTEQ(size_t, lua_objlen(to, -1), 100000);
+	lua_rawget(to, -2);
+	UASSERTEQ(int, lua_tointeger(to, -1), 1);
+	lua_getfield(to, -2, "small");
+	UASSERTEQ(std::string, lua_tostring(to, -1), "abc");
+	lua_pop(to, 3);
+
+	script_release_borrowed(from, pv.get());
+	UASSERT(pv->borrowed[0].data == nullptr);
+
+	// Without borrowing everything is copied
+	run(from, "return string.rep('x', 100000)", 1);
+	pv.reset(script_pack(from, -1));
+	lua_pop(from, 1);
+	UASSERT(pv->borrowed.empty());
+
+	lua_close(to);
+	lua_close(from);
+}
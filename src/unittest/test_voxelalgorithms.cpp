@@ -6,9 +6,14 @@
 
 #include "gamedef.h"
 #include "voxelalgorithms.h"
+#include "util/directiontables.h"
 #include "util/numeric.h"
 #include "dummymap.h"
 #include "nodedef.h"
+#include "mapgen/mapgen.h"
+#include "noise.h"
+
+#include <queue>
 
 class TestVoxelAlgorithms : public TestBase {
 public:
@@ -19,6 +24,8 @@ class TestVoxelAlgorithms : public TestBase {
 
 	void testVoxelLineIterator();
 	void testLighting(IGameDef *gamedef);
+	void testBlitBackWithLight(IGameDef *gamedef);
+	void testMapgenLighting(IGameDef *gamedef);
 };
 
 static TestVoxelAlgorithms g_test_instance;
@@ -27,6 +34,8 @@ void TestVoxelAlgorithms::runTests(IGameDef *gamedef)
 {
 	TEST(testVoxelLineIterator);
 	TEST(testLighting, gamedef);
+	TEST(testBlitBackWithLight, gamedef);
+	TEST(testMapgenLighting, gamedef);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -153,3 +162,196 @@ void TestVoxelAlgorithms::testLighting(IGameDef *gamedef)
 		UASSERTEQ(int, n.getParam1(), 153);
 	}
 }
+
+void TestVoxelAlgorithms::testBlitBackWithLight(IGameDef *gamedef)
+{
+	constexpr int bs = MAP_BLOCKSIZE;
+	const v3s16 bpmin(-1, -1, -1), bpmax(1, 1, 1);
+	DummyMap map(gamedef, bpmin, bpmax);
+
+	{
+		std::map<v3s16, MapBlock*> modified_blocks;
+		MMVManip vm(&map);
+		vm.initialEmerge(bpmin, bpmax, false);
+		u32 volume = vm.m_area.getVolume();
+		for (u32 i = 0; i < volume; i++)
+			vm.m_data[i] = MapNode(CONTENT_AIR);
+		voxalgo::blit_back_with_light(&map, &vm, &modified_blocks);
+		UASSERTEQ(size_t, modified_blocks.size(), 27);
+	}
+
+	MMVManip vm(&map);
+	vm.initialEmerge(bpmin, bpmax, false);
+
+	// Nothing changed, so nothing is written
+	{
+		std::map<v3s16, MapBlock*> modified_blocks;
+		voxalgo::blit_back_with_light(&map, &vm, &modified_blocks);
+		UASSERT(modified_blocks.empty());
+	}
+
+	// A torch in the middle of a block only lights the blocks next to it
+	{
+		std::map<v3s16, MapBlock*> modified_blocks;
+		vm.setNodeNoEmerge(v3s16(bs / 2), MapNode(t_CONTENT_TORCH));
+		voxalgo::blit_back_with_light(&map, &vm, &modified_blocks);
+		UASSERT(modified_blocks.count(v3s16(0, 0, 0)));
+		UASSERT(!modified_blocks.count(v3s16(-1, -1, -1)));
+		UASSERT(!modified_blocks.count(v3s16(1, 1, 1)));
+	}
+
+	const NodeDefManager *ndef = gamedef->ndef();
+	UASSERTEQ(auto, map.getNode(v3s16(bs / 2)).getContent(), t_CONTENT_TORCH);
+	{
+		// Light reaches into the block below
+		MapNode n = map.getNode(v3s16(bs / 2, -1, bs / 2));
+		UASSERTEQ(int, n.getLight(LIGHTBANK_NIGHT, ndef->getLightingFlags(n)),
+			LIGHT_MAX - 1 - (bs / 2 + 1));
+	}
+}
+
+namespace {
+
+// Sunlight propagation column by column, like Mapgen::propagateSunlight()
+// used to do it
+void reference_sunlight(MMVManip &vm, const NodeDefManager *ndef,
+	v3s16 nmin, v3s16 nmax, bool underground, bool propagate_shadow)
+{
+	for (s16 z = nmin.Z; z <= nmax.Z; z++)
+	for (s16 x = nmin.X; x <= nmax.X; x++) {
+		MapNode top = vm.m_data[vm.m_area.index(x, nmax.Y + 1, z)];
+		if (top.getContent() == CONTENT_IGNORE) {
+			if (underground)
+				continue;
+		} else if ((top.param1 & 0x0F) != LIGHT_SUN && propagate_shadow) {
+			continue;
+		}
+		for (s16 y = nmax.Y; y >= nmin.Y; y--) {
+			MapNode &n = vm.m_data[vm.m_area.index(x, y, z)];
+			if (!ndef->getLightingFlags(n).sunlight_propagates)
+				break;
+			n.param1 = LIGHT_SUN;
+		}
+	}
+}
+
+// Light spread with a lightSpread() call for every neighbor of every lit
+// node, like Mapgen::spreadLight() used to do it. Light sources overwrite
+// light that already reached them, so the result depends on the order
+// nodes are visited in.
+void reference_spread(MMVManip &vm, const NodeDefManager *ndef,
+	v3s16 nmin, v3s16 nmax)
+{
+	VoxelArea a(nmin, nmax);
+	std::queue<std::pair<v3s16, u8>> queue;
+	auto light_spread = [&] (const v3s16 &p, u8 light) {
+		if (light <= 1 || !a.contains(p))
+			return;
+		MapNode &n = vm.m_data[vm.m_area.index(p)];
+		u8 light_day = light & 0x0F;
+		if (light_day > 0)
+			light_day -= 0x01;
+		u8 light_night = light & 0xF0;
+		if (light_night > 0)
+			light_night -= 0x10;
+		if ((light_day <= (n.param1 & 0x0F) &&
+				light_night <= (n.param1 & 0xF0)) ||
+				!ndef->getLightingFlags(n).light_propagates)
+			return;
+		n.param1 = MYMAX(light_day, n.param1 & 0x0F) |
+				MYMAX(light_night, n.param1 & 0xF0);
+		queue.emplace(p, n.param1);
+	};
+
+	for (s16 z = nmin.Z; z <= nmax.Z; z++)
+	for (s16 y = nmin.Y; y <= nmax.Y; y++)
+	for (s16 x = nmin.X; x <= nmax.X; x++) {
+		const v3s16 p(x, y, z);
+		MapNode &n = vm.m_data[vm.m_area.index(p)];
+		if (n.getContent() == CONTENT_IGNORE)
+			continue;
+		ContentLightingFlags cf = ndef->getLightingFlags(n);
+		if (!cf.light_propagates)
+			continue;
+		if (cf.light_source)
+			n.param1 = cf.light_source | (cf.light_source << 4);
+		if (n.param1) {
+			for (const v3s16 &dir : g_6dirs)
+				light_spread(p + dir, n.param1);
+		}
+	}
+
+	while (!queue.empty()) {
+		const auto i = queue.front();
+		queue.pop();
+		for (const v3s16 &dir : g_6dirs)
+			light_spread(i.first + dir, i.second);
+	}
+}
+
+// Runs a lighting step and its reference on the same data and checks that
+// they give the same light
+template <typename F, typename R>
+void check(MMVManip &vm, F step, R reference)
+{
+	const u32 volume = vm.m_area.getVolume();
+	std::vector<MapNode> before(vm.m_data, vm.m_data + volume);
+	reference();
+	std::vector<MapNode> expected(vm.m_data, vm.m_data + volume);
+	std::copy(before.begin(), before.end(), vm.m_data);
+	step();
+	for (u32 i = 0; i < volume; i++)
+		UASSERTEQ(int, vm.m_data[i].param1, expected[i].param1);
+}
+
+}
+
+void TestVoxelAlgorithms::testMapgenLighting(IGameDef *gamedef)
+{
+	const NodeDefManager *ndef = gamedef->ndef();
+	const content_t contents[] = {CONTENT_AIR, CONTENT_AIR, CONTENT_AIR,
+		t_CONTENT_STONE, t_CONTENT_WATER, t_CONTENT_TORCH};
+
+	// The area to light, with one layer of nodes around it
+	const v3s16 nmin(0, 0, 0), nmax(19, 19, 19);
+	const v3s16 full_nmin = nmin - v3s16(1), full_nmax = nmax + v3s16(1);
+	DummyMap map(gamedef, v3s16(0, 0, 0), v3s16(-1, -1, -1));
+	MMVManip vm(&map);
+	vm.addArea(VoxelArea(full_nmin, full_nmax));
+	const u32 volume = vm.m_area.getVolume();
+
+	Mapgen mg;
+	mg.vm = &vm;
+	mg.ndef = ndef;
+
+	PcgRandom pr(1234);
+	for (int round = 0; round < 4; round++) {
+		const bool underground = round & 1;
+		const bool propagate_shadow = round & 2;
+		mg.water_level = underground ? nmax.Y : nmin.Y - 1;
+
+		for (u32 i = 0; i < volume; i++)
+			vm.m_data[i] = MapNode(contents[pr.range(0, ARRLEN(contents) - 1)]);
+		// The layer above is partly not generated and partly lit
+		for (s16 z = full_nmin.Z; z <= full_nmax.Z; z++)
+		for (s16 x = full_nmin.X; x <= full_nmax.X; x++) {
+			MapNode &n = vm.m_data[vm.m_area.index(x, full_nmax.Y, z)];
+			s32 r = pr.range(0, 2);
+			if (r == 0)
+				n = MapNode(CONTENT_IGNORE);
+			else if (r == 1)
+				n.param1 = LIGHT_SUN;
+		}
+
+		check(vm, [&] {
+			mg.propagateSunlight(nmin, nmax, propagate_shadow);
+		}, [&] {
+			reference_sunlight(vm, ndef, nmin, nmax, underground, propagate_shadow);
+		});
+		check(vm, [&] {
+			mg.spreadLight(full_nmin, full_nmax);
+		}, [&] {
+			reference_spread(vm, ndef, full_nmin, full_nmax);
+		});
+	}
+}
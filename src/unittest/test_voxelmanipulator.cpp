@@ -23,6 +23,8 @@ class TestVoxelManipulator : public TestBase {
 	void testEmerge(IGameDef *gamedef);
 	void testBlitBack(IGameDef *gamedef);
 	void testBlitBack2(IGameDef *gamedef);
+	void testBlitBackChanged(IGameDef *gamedef);
+	void testBufferReuse();
 };
 
 static TestVoxelManipulator g_test_instance;
@@ -33,6 +35,8 @@ void TestVoxelManipulator::runTests(IGameDef *gamedef)
 	TEST(testEmerge, gamedef);
 	TEST(testBlitBack, gamedef);
 	TEST(testBlitBack2, gamedef);
+	TEST(testBlitBackChanged, gamedef);
+	TEST(testBufferReuse);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -179,3 +183,64 @@ void TestVoxelManipulator::testBlitBack2(IGameDef *gamedef)
 	// The upper one should not!
 	UASSERTEQ(auto, map.getNode({0,bs,0}).getContent(), CONTENT_AIR);
 }
+
+void TestVoxelManipulator::testBlitBackChanged(IGameDef *gamedef)
+{
+	DummyMap map(gamedef, {-1,-1,-1}, {1,1,1});
+	map.fill({-1,-1,-1}, {1,1,1}, CONTENT_AIR);
+
+	MMVManip vm(&map);
+	vm.initialEmerge({-1,-1,-1}, {1,1,1});
+	UASSERT(vm.getChangedBlocks().empty());
+
+	// Writing back an unchanged VManip does not touch the map
+	{
+		std::map<v3s16, MapBlock*> modified;
+		vm.blitBackAll(&modified);
+		UASSERT(modified.empty());
+	}
+
+	// Setting a node to the same value is not a change either
+	vm.setNodeNoEmerge({0,0,0}, CONTENT_AIR);
+	UASSERT(vm.getChangedBlocks().empty());
+
+	vm.setNodeNoEmerge({MAP_BLOCKSIZE,0,0}, t_CONTENT_STONE);
+	{
+		auto changed = vm.getChangedBlocks();
+		UASSERTEQ(size_t, changed.size(), 1);
+		UASSERTEQ(auto, changed[0], v3s16(1,0,0));
+	}
+	{
+		std::map<v3s16, MapBlock*> modified;
+		vm.blitBackAll(&modified);
+		UASSERTEQ(size_t, modified.size(), 1);
+		UASSERTEQ(auto, modified.begin()->first, v3s16(1,0,0));
+	}
+	UASSERTEQ(auto, map.getNode({MAP_BLOCKSIZE,0,0}).getContent(), t_CONTENT_STONE);
+	UASSERT(vm.getChangedBlocks().empty());
+}
+
+void TestVoxelManipulator::testBufferReuse()
+{
+	const VoxelArea area({-20, -20, -20}, {19, 19, 19});
+	MapNode *data;
+	{
+		VoxelManipulator v;
+		v.addArea(area);
+		data = v.m_data;
+	}
+
+	// Same volume at a different position, gets the freed buffers
+	VoxelManipulator v;
+	v.addArea(VoxelArea({0, 0, 0}, {39, 39, 39}));
+	UASSERT(v.m_data == data);
+	// Flags are reset
+	UASSERT(v.getFlagsRefUnsafe({5, 5, 5}) & VOXELFLAG_NO_DATA);
+
+	// Growing copies the data into new buffers
+	v.setNode({1, 2, 3}, MapNode(CONTENT_AIR, 0, 42));
+	v.addArea(VoxelArea({40, 0, 0}));
+	UASSERT(v.m_data != data);
+	UASSERT(v.getNode({1, 2, 3}) == MapNode(CONTENT_AIR, 0, 42));
+	UASSERT(v.getFlagsRefUnsafe({20, 20, 20}) & VOXELFLAG_NO_DATA);
+}
@@ -13,6 +13,7 @@
 #include <vector>
 #include <map>
 #include <set>
+#include <unordered_set>
 #include <queue>
 #include <cassert>
 #include <limits>
@@ -64,7 +65,7 @@ class UniqueQueue
 	}
 
 private:
-	std::set<Value> m_set;
+	std::unordered_set<Value> m_set;
 	std::queue<Value> m_queue;
 };
 
@@ -10,12 +10,121 @@
 #include "util/timetaker.h"
 #include "porting.h"
 #include <cstring>  // memcpy, memset
+#include <vector>
 
 /*
 	Debug stuff
 */
 u64 emerge_time = 0;
 
+/*
+	Buffer pool
+
+	Emerge threads and Lua create a VoxelManipulator per mapchunk or call,
+	mostly with the same few area sizes. Freed buffers are kept per thread
+	and handed out again for the same volume, which avoids allocator churn
+	and page faults on large buffers.
+*/
+
+namespace {
+
+class VoxelBufferPool
+{
+public:
+	~VoxelBufferPool()
+	{
+		for (auto &b : m_free)
+			freeBuffers(b);
+		s_destroyed = true;
+	}
+
+	bool take(u32 volume, MapNode *&data, u8 *&flags)
+	{
+		// Most recently freed first, it's more likely to still be in the cache
+		for (auto it = m_free.rbegin(); it != m_free.rend(); ++it) {
+			if (it->volume != volume)
+				continue;
+			data = it->data;
+			flags = it->flags;
+			m_free_bytes -= bufferBytes(volume);
+			m_free.erase(std::next(it).base());
+			return true;
+		}
+		return false;
+	}
+
+	void give(u32 volume, MapNode *data, u8 *flags)
+	{
+		if (bufferBytes(volume) > max_free_bytes) {
+			freeBuffers({volume, data, flags});
+			return;
+		}
+		m_free.push_back({volume, data, flags});
+		m_free_bytes += bufferBytes(volume);
+		// Drop the oldest buffers when over the limits
+		while (m_free.size() > max_free_count || m_free_bytes > max_free_bytes) {
+			m_free_bytes -= bufferBytes(m_free.front().volume);
+			freeBuffers(m_free.front());
+			m_free.erase(m_free.begin());
+		}
+	}
+
+	// Buffers may be freed after the pool of the thread is gone
+	static thread_local bool s_destroyed;
+
+private:
+	struct Buffers {
+		u32 volume;
+		MapNode *data;
+		u8 *flags;
+	};
+
+	// Enough for a mapgen VoxelManipulator of the default chunk size
+	static constexpr size_t max_free_bytes = 16 * 1024 * 1024;
+	static constexpr size_t max_free_count = 4;
+
+	static size_t bufferBytes(u32 volume)
+	{
+		return (sizeof(MapNode) + sizeof(u8)) * volume;
+	}
+
+	static void freeBuffers(const Buffers &b)
+	{
+		delete[] b.data;
+		delete[] b.flags;
+		porting::TrackFreedMemory(bufferBytes(b.volume));
+	}
+
+	std::vector<Buffers> m_free;
+	size_t m_free_bytes = 0;
+};
+
+thread_local bool VoxelBufferPool::s_destroyed = false;
+thread_local VoxelBufferPool g_buffer_pool;
+
+void allocate_buffers(u32 volume, MapNode *&data, u8 *&flags)
+{
+	if (!VoxelBufferPool::s_destroyed && g_buffer_pool.take(volume, data, flags))
+		return;
+	data = new MapNode[volume];
+	flags = new u8[volume];
+}
+
+void free_buffers(u32 volume, MapNode *data, u8 *flags)
+{
+	if (!data)
+		return;
+	if (!VoxelBufferPool::s_destroyed) {
+		g_buffer_pool.give(volume, data, flags);
+		return;
+	}
+	delete[] data;
+	delete[] flags;
+	porting::TrackFreedMemory((sizeof(MapNode) + sizeof(u8)) * volume);
+}
+
+}
+
 VoxelManipulator::~VoxelManipulator()
 {
 	clear();
@@ -26,12 +135,9 @@ void VoxelManipulator::clear()
 	// Reset area to empty volume
 	VoxelArea old;
 	std::swap(m_area, old);
-	delete[] m_data;
+	free_buffers(old.getVolume(), m_data, m_flags);
 	m_data = nullptr;
-	delete[] m_flags;
 	m_flags = nullptr;
-
-	porting::TrackFreedMemory((sizeof(*m_data) + sizeof(*m_flags)) * old.getVolume());
 }
 
 void VoxelManipulator::print(std::ostream &o, const NodeDefManager *ndef,
@@ -143,10 +249,9 @@ void VoxelManipulator::addArea(const VoxelArea &area)
 	u32 new_size = new_area.getVolume();
 
 	// Allocate new data and clear flags
-	MapNode *new_data = new MapNode[new_size];
-	assert(new_data);
-	u8 *new_flags = new u8[new_size];
-	assert(new_flags);
+	MapNode *new_data;
+	u8 *new_flags;
+	allocate_buffers(new_size, new_data, new_flags);
 	memset(new_flags, VOXELFLAG_NO_DATA, new_size);
 
 	// Copy old data
@@ -165,6 +270,7 @@ void VoxelManipulator::addArea(const VoxelArea &area)
 
 	// Replace area, data and flags
 
+	const u32 old_size = m_area.getVolume();
 	m_area = new_area;
 
 	MapNode *old_data = m_data;
@@ -173,8 +279,7 @@ void VoxelManipulator::addArea(const VoxelArea &area)
 	m_data = new_data;
 	m_flags = new_flags;
 
-	delete[] old_data;
-	delete[] old_flags;
+	free_buffers(old_size, old_data, old_flags);
 }
 
 void VoxelManipulator::copyFrom(MapNode *src, const VoxelArea& src_area,
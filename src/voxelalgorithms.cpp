@@ -239,7 +239,7 @@ bool step_rel_block_pos(direction dir, relative_v3 &rel_pos,
  * \param light_sources nodes that should be re-lighted
  * \param modified_blocks output, all modified map blocks are added to this
  */
-void unspread_light(Map *map, const NodeDefManager *nodemgr, LightBank bank,
+void unspread_light(MapBlockCache &blocks, const NodeDefManager *nodemgr, LightBank bank,
 	UnlightQueue &from_nodes, ReLightQueue &light_sources,
 	std::map<v3s16, MapBlock*> &modified_blocks)
 {
@@ -275,7 +275,7 @@ void unspread_light(Map *map, const NodeDefManager *nodemgr, LightBank bank,
 			neighbor_block_pos = current.block_position;
 			MapBlock *neighbor_block;
 			if (step_rel_block_pos(i, neighbor_rel_pos, neighbor_block_pos)) {
-				neighbor_block = map->getBlockNoCreateNoEx(neighbor_block_pos);
+				neighbor_block = blocks.getBlockNoCreateNoEx(neighbor_block_pos);
 				if (neighbor_block == NULL) {
 					current.block->setLightingComplete(bank, i, false);
 					continue;
@@ -339,7 +339,7 @@ void unspread_light(Map *map, const NodeDefManager *nodemgr, LightBank bank,
  * \param light_sources starting nodes
  * \param modified_blocks output, all modified map blocks are added to this
  */
-void spread_light(Map *map, const NodeDefManager *nodemgr, LightBank bank,
+void spread_light(MapBlockCache &blocks, const NodeDefManager *nodemgr, LightBank bank,
 	LightQueue &light_sources,
 	std::map<v3s16, MapBlock*> &modified_blocks)
 {
@@ -362,7 +362,7 @@ void spread_light(Map *map, const NodeDefManager *nodemgr, LightBank bank,
 			neighbor_block_pos = current.block_position;
 			MapBlock *neighbor_block;
 			if (step_rel_block_pos(i, neighbor_rel_pos, neighbor_block_pos)) {
-				neighbor_block = map->getBlockNoCreateNoEx(neighbor_block_pos);
+				neighbor_block = blocks.getBlockNoCreateNoEx(neighbor_block_pos);
 				if (neighbor_block == NULL) {
 					current.block->setLightingComplete(bank, i, false);
 					continue;
@@ -413,7 +413,7 @@ struct SunlightPropagationData{
  *
  * \param pos position of the node.
  */
-bool is_sunlight_above(Map *map, v3s16 pos, const NodeDefManager *ndef)
+bool is_sunlight_above(MapBlockCache &blocks, v3s16 pos, const NodeDefManager *ndef)
 {
 	bool sunlight = true;
 	mapblock_v3 source_block_pos;
@@ -421,10 +421,10 @@ bool is_sunlight_above(Map *map, v3s16 pos, const NodeDefManager *ndef)
 	getNodeBlockPosWithOffset(pos + v3s16(0, 1, 0), source_block_pos,
 		source_rel_pos);
 	// If the node above has sunlight, this node also can get it.
-	MapBlock *source_block = map->getBlockNoCreateNoEx(source_block_pos);
+	MapBlock *source_block = blocks.getBlockNoCreateNoEx(source_block_pos);
 	if (source_block == NULL) {
 		// But if there is no node above, then use heuristics
-		MapBlock *node_block = map->getBlockNoCreateNoEx(getNodeBlockPos(pos));
+		MapBlock *node_block = blocks.getBlockNoCreateNoEx(getNodeBlockPos(pos));
 		if (node_block == NULL) {
 			sunlight = false;
 		} else {
@@ -456,6 +456,7 @@ void update_lighting_nodes(Map *map,
 	std::map<v3s16, MapBlock*> &modified_blocks)
 {
 	const NodeDefManager *ndef = map->getNodeDefManager();
+	MapBlockCache blocks(map);
 	// For node getter functions
 	bool is_valid_position;
 
@@ -489,7 +490,7 @@ void update_lighting_nodes(Map *map,
 			relative_v3 rel_pos;
 			mapblock_v3 block_pos;
 			getNodeBlockPosWithOffset(p, block_pos, rel_pos);
-			MapBlock *block = map->getBlockNoCreateNoEx(block_pos);
+			MapBlock *block = blocks.getBlockNoCreateNoEx(block_pos);
 			if (block == NULL) {
 				continue;
 			}
@@ -507,13 +508,13 @@ void update_lighting_nodes(Map *map,
 			ContentLightingFlags f = ndef->getLightingFlags(n);
 			if (f.light_propagates) {
 				if (bank == LIGHTBANK_DAY && f.sunlight_propagates
-					&& is_sunlight_above(map, p, ndef)) {
+					&& is_sunlight_above(blocks, p, ndef)) {
 					new_light = LIGHT_SUN;
 				} else {
 					new_light = f.light_source;
 					for (const v3s16 &neighbor_dir : neighbor_dirs) {
 						v3s16 p2 = p + neighbor_dir;
-						MapNode n2 = map->getNode(p2, &is_valid_position);
+						MapNode n2 = blocks.getNode(p2, &is_valid_position);
 						if (is_valid_position) {
 							u8 spread = n2.getLight(bank, ndef->getLightingFlags(n2));
 							// If it is sure that the neighbor won't be
@@ -550,7 +551,7 @@ void update_lighting_nodes(Map *map,
 
 						MapNode n2;
 
-						n2 = map->getNode(n2pos, &is_valid_position);
+						n2 = blocks.getNode(n2pos, &is_valid_position);
 						if (!is_valid_position)
 							break;
 
@@ -566,7 +567,7 @@ void update_lighting_nodes(Map *map,
 						relative_v3 rel_pos2;
 						mapblock_v3 block_pos2;
 						getNodeBlockPosWithOffset(n2pos, block_pos2, rel_pos2);
-						MapBlock *block2 = map->getBlockNoCreateNoEx(
+						MapBlock *block2 = blocks.getBlockNoCreateNoEx(
 							block_pos2);
 						disappearing_lights.push(LIGHT_SUN, rel_pos2,
 							block_pos2, block2,
@@ -583,7 +584,7 @@ void update_lighting_nodes(Map *map,
 
 						MapNode n2;
 
-						n2 = map->getNode(n2pos, &is_valid_position);
+						n2 = blocks.getNode(n2pos, &is_valid_position);
 						if (!is_valid_position)
 							break;
 
@@ -600,7 +601,7 @@ void update_lighting_nodes(Map *map,
 						relative_v3 rel_pos2;
 						mapblock_v3 block_pos2;
 						getNodeBlockPosWithOffset(n2pos, block_pos2, rel_pos2);
-						MapBlock *block2 = map->getBlockNoCreateNoEx(
+						MapBlock *block2 = blocks.getBlockNoCreateNoEx(
 							block_pos2);
 						// Mark node for lighting.
 						light_sources.push(LIGHT_SUN, rel_pos2, block_pos2,
@@ -611,7 +612,7 @@ void update_lighting_nodes(Map *map,
 
 		}
 		// Remove lights
-		unspread_light(map, ndef, bank, disappearing_lights, light_sources,
+		unspread_light(blocks, ndef, bank, disappearing_lights, light_sources,
 			modified_blocks);
 		// Initialize light values for light spreading.
 		for (u8 i = 0; i <= LIGHT_SUN; i++) {
@@ -623,8 +624,9 @@ void update_lighting_nodes(Map *map,
 			}
 		}
 		// Spread lights.
-		spread_light(map, ndef, bank, light_sources, modified_blocks);
+		spread_light(blocks, ndef, bank, light_sources, modified_blocks);
 	}
+	blocks.reportHitRate("voxalgo: block cache hits [%]");
 }
 
 /*!
@@ -650,11 +652,11 @@ const static VoxelArea block_borders[] = {
  * its light source and its brightest neighbor minus one.
  * .
  */
-bool is_light_locally_correct(Map *map, const NodeDefManager *ndef,
+bool is_light_locally_correct(MapBlockCache &blocks, const NodeDefManager *ndef,
 	LightBank bank, v3s16 pos)
 {
 	bool is_valid_position;
-	MapNode n = map->getNode(pos, &is_valid_position);
+	MapNode n = blocks.getNode(pos, &is_valid_position);
 	ContentLightingFlags f = ndef->getLightingFlags(n);
 	if (!f.has_light) {
 		return true;
@@ -663,7 +665,7 @@ bool is_light_locally_correct(Map *map, const NodeDefManager *ndef,
 	assert(f.light_source <= LIGHT_MAX);
 	u8 brightest_neighbor = f.light_source + 1;
 	for (const v3s16 &neighbor_dir : neighbor_dirs) {
-		MapNode n2 = map->getNode(pos + neighbor_dir,
+		MapNode n2 = blocks.getNode(pos + neighbor_dir,
 			&is_valid_position);
 		u8 light2 = n2.getLight(bank, ndef->getLightingFlags(n2));
 		if (brightest_neighbor < light2) {
@@ -678,6 +680,7 @@ void update_block_border_lighting(Map *map, MapBlock *block,
 	std::map<v3s16, MapBlock*> &modified_blocks)
 {
 	const NodeDefManager *ndef = map->getNodeDefManager();
+	MapBlockCache blocks(map);
 	// Since invalid light is not common, do not allocate
 	// memory if not needed.
 	UnlightQueue disappearing_lights(0);
@@ -691,7 +694,7 @@ void update_block_border_lighting(Map *map, MapBlock *block,
 			// For each direction
 			// Get neighbor block
 			v3s16 otherpos = block->getPos() + neighbor_dirs[d];
-			MapBlock *other = map->getBlockNoCreateNoEx(otherpos);
+			MapBlock *other = blocks.getBlockNoCreateNoEx(otherpos);
 			if (other == NULL) {
 				continue;
 			}
@@ -703,11 +706,11 @@ void update_block_border_lighting(Map *map, MapBlock *block,
 			block->setLightingComplete(bank, d, true);
 			other->setLightingComplete(bank, 5 - d, true);
 			// The two blocks and their connecting surfaces
-			MapBlock *blocks[] = {block, other};
+			MapBlock *border_blocks[] = {block, other};
 			VoxelArea areas[] = {block_borders[d], block_borders[5 - d]};
 			// For both blocks
 			for (u8 blocknum = 0; blocknum < 2; blocknum++) {
-				MapBlock *b = blocks[blocknum];
+				MapBlock *b = border_blocks[blocknum];
 				VoxelArea a = areas[blocknum];
 				// For all nodes
 				for (s32 x = a.MinEdge.X; x <= a.MaxEdge.X; x++)
@@ -719,7 +722,7 @@ void update_block_border_lighting(Map *map, MapBlock *block,
 					// Sunlight is fixed
 					if (light < LIGHT_SUN) {
 						// Unlight if not correct
-						if (!is_light_locally_correct(map, ndef, bank,
+						if (!is_light_locally_correct(blocks, ndef, bank,
 								v3s16(x, y, z) + b->getPosRelative())) {
 							// Initialize for unlighting
 							n.setLight(bank, 0, ndef->getLightingFlags(n));
@@ -734,7 +737,7 @@ void update_block_border_lighting(Map *map, MapBlock *block,
 			}
 		}
 		// Remove lights
-		unspread_light(map, ndef, bank, disappearing_lights, light_sources,
+		unspread_light(blocks, ndef, bank, disappearing_lights, light_sources,
 			modified_blocks);
 		// Initialize light values for light spreading.
 		for (u8 i = 0; i <= LIGHT_SUN; i++) {
@@ -746,8 +749,9 @@ void update_block_border_lighting(Map *map, MapBlock *block,
 			}
 		}
 		// Spread lights.
-		spread_light(map, ndef, bank, light_sources, modified_blocks);
+		spread_light(blocks, ndef, bank, light_sources, modified_blocks);
 	}
+	blocks.reportHitRate("voxalgo: block cache hits [%]");
 }
 
 /*!
@@ -766,24 +770,15 @@ void update_block_border_lighting(Map *map, MapBlock *block,
 void fill_with_sunlight(MMVManip *vm, const NodeDefManager *ndef, v2s16 offset,
 	bool light[MAP_BLOCKSIZE][MAP_BLOCKSIZE])
 {
-	// Distance in array between two nodes on top of each other.
-	s32 ystride = vm->m_area.getExtent().X;
 	// Cache the ignore node.
 	MapNode ignore = MapNode(CONTENT_IGNORE);
-	// For each column of nodes:
-	for (s16 z = 0; z < MAP_BLOCKSIZE; z++)
-	for (s16 x = 0; x < MAP_BLOCKSIZE; x++) {
-		// Position of the column on the map.
-		v2s16 realpos = offset + v2s16(x, z);
-		// Array indices in the voxel manipulator
-		s32 maxindex = vm->m_area.index(realpos.X, vm->m_area.MaxEdge.Y,
-			realpos.Y);
-		s32 minindex = vm->m_area.index(realpos.X, vm->m_area.MinEdge.Y,
-			realpos.Y);
-		// True if the current node has sunlight.
-		bool lig = light[z][x];
-		// For each node, downwards:
-		for (s32 i = maxindex; i >= minindex; i -= ystride) {
+	// Walk the sector layer by layer, downwards, so that the voxel
+	// manipulator is accessed along its X rows. light[z][x] is true while
+	// the column still has sunlight, which is also the outgoing light.
+	for (s16 y = vm->m_area.MaxEdge.Y; y >= vm->m_area.MinEdge.Y; y--)
+	for (s16 z = 0; z < MAP_BLOCKSIZE; z++) {
+		s32 i = vm->m_area.index(offset.X, y, offset.Y + z);
+		for (s16 x = 0; x < MAP_BLOCKSIZE; x++, i++) {
 			MapNode *n;
 			if (vm->m_flags[i] & VOXELFLAG_NO_DATA)
 				n = &ignore;
@@ -793,6 +788,7 @@ void fill_with_sunlight(MMVManip *vm, const NodeDefManager *ndef, v2s16 offset,
 			if(n->getContent() == CONTENT_IGNORE)
 				continue;
 			ContentLightingFlags f = ndef->getLightingFlags(*n);
+			bool &lig = light[z][x];
 			if (lig && !f.sunlight_propagates)
 				// Sunlight is stopped.
 				lig = false;
@@ -800,8 +796,6 @@ void fill_with_sunlight(MMVManip *vm, const NodeDefManager *ndef, v2s16 offset,
 			n->setLight(LIGHTBANK_DAY, lig ? 15 : 0, f);
 			n->setLight(LIGHTBANK_NIGHT, 0, f);
 		}
-		// Output outgoing light.
-		light[z][x] = lig;
 	}
 }
 
@@ -966,12 +960,13 @@ void finish_bulk_light_update(Map *map, mapblock_v3 minblock,
 	std::map<v3s16, MapBlock*> *modified_blocks)
 {
 	const NodeDefManager *ndef = map->getNodeDefManager();
+	MapBlockCache blocks(map);
 
 	// --- STEP 1: Do unlighting
 
 	for (size_t bank = 0; bank < 2; bank++) {
 		LightBank b = banks[bank];
-		unspread_light(map, ndef, b, unlight[bank], relight[bank],
+		unspread_light(blocks, ndef, b, unlight[bank], relight[bank],
 			*modified_blocks);
 	}
 
@@ -983,7 +978,7 @@ void finish_bulk_light_update(Map *map, mapblock_v3 minblock,
 	for (blockpos.X = minblock.X; blockpos.X <= maxblock.X; blockpos.X++)
 	for (blockpos.Y = minblock.Y; blockpos.Y <= maxblock.Y; blockpos.Y++)
 	for (blockpos.Z = minblock.Z; blockpos.Z <= maxblock.Z; blockpos.Z++) {
-		MapBlock *block = map->getBlockNoCreateNoEx(blockpos);
+		MapBlock *block = blocks.getBlockNoCreateNoEx(blockpos);
 		if (!block)
 			// Skip not existing blocks
 			continue;
@@ -1023,17 +1018,36 @@ void finish_bulk_light_update(Map *map, mapblock_v3 minblock,
 			}
 		}
 		// Spread lights.
-		spread_light(map, ndef, bank, relight[b], *modified_blocks);
+		spread_light(blocks, ndef, bank, relight[b], *modified_blocks);
 	}
+	blocks.reportHitRate("voxalgo: block cache hits [%]");
 }
 
-void blit_back_with_light(Map *map, MMVManip *vm,
+/*!
+ * Copies the nodes and flags in the given area from one
+ * voxel manipulator to another. Both must contain the area.
+ */
+static void copy_area(VoxelManipulator *dst, const VoxelManipulator *src,
+	const VoxelArea &a)
+{
+	const u32 row = a.getExtent().X;
+	for (s16 z = a.MinEdge.Z; z <= a.MaxEdge.Z; z++)
+	for (s16 y = a.MinEdge.Y; y <= a.MaxEdge.Y; y++) {
+		const u32 i_src = src->m_area.index(a.MinEdge.X, y, z);
+		const u32 i_dst = dst->m_area.index(a.MinEdge.X, y, z);
+		memcpy(&dst->m_data[i_dst], &src->m_data[i_src], row * sizeof(MapNode));
+		memcpy(&dst->m_flags[i_dst], &src->m_flags[i_src], row * sizeof(u8));
+	}
+}
+
+/*!
+ * Does the work of blit_back_with_light on the whole voxel manipulator.
+ */
+static void relight_and_blit_back(Map *map, MMVManip *vm,
 	std::map<v3s16, MapBlock*> *modified_blocks)
 {
 	const NodeDefManager *ndef = map->getNodeDefManager();
 
-	if (vm->m_area.hasEmptyExtent())
-		return;
 	mapblock_v3 minblock = getNodeBlockPos(vm->m_area.MinEdge);
 	mapblock_v3 maxblock = getNodeBlockPos(vm->m_area.MaxEdge);
 	// First queue is for day light, second is for night light.
@@ -1127,6 +1141,36 @@ void blit_back_with_light(Map *map, MMVManip *vm,
 		modified_blocks);
 }
 
+void blit_back_with_light(Map *map, MMVManip *vm,
+	std::map<v3s16, MapBlock*> *modified_blocks)
+{
+	if (vm->m_area.hasEmptyExtent())
+		return;
+
+	// Usually only a part of the voxel manipulator was changed, so find
+	// the blocks that actually differ from the map.
+	const std::vector<v3s16> changed_blocks = vm->getChangedBlocks();
+	if (changed_blocks.empty())
+		return;
+	VoxelArea changed_area;
+	for (v3s16 bp : changed_blocks) {
+		v3s16 pmin = bp * MAP_BLOCKSIZE;
+		changed_area.addArea(VoxelArea(pmin, pmin + v3s16(MAP_BLOCKSIZE - 1)));
+	}
+	if (changed_area == vm->m_area) {
+		relight_and_blit_back(map, vm, modified_blocks);
+		return;
+	}
+
+	// Outside of the changed area the nodes are the same as in the map,
+	// so it is enough to relight and write back the changed area.
+	MMVManip changed_vm(map);
+	changed_vm.addArea(changed_area);
+	copy_area(&changed_vm, vm, changed_area);
+	relight_and_blit_back(map, &changed_vm, modified_blocks);
+	copy_area(vm, &changed_vm, changed_area);
+}
+
 /*!
  * Resets the lighting of the given map block to
  * complete darkness and full sunlight.
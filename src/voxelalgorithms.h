@@ -47,6 +47,8 @@ void update_block_border_lighting(Map *map, MapBlock *block,
 /*!
  * Copies back nodes from a voxel manipulator
  * to the map and updates lighting.
+ * Only the map blocks whose data differs from the map
+ * are relit and written.
  * For server use only.
  *
  * \param modified_blocks output, contains all map blocks that